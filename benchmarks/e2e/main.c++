@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <args/parser.h++>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <http/middlewares/response.h++>
+#include <http/options.h++>
+#include <http/server.h++>
+#include <iostream>
+#include <netinet/tcp.h>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <utils/logger.h++>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+using backend = io::event_loop::backend;
+
+// Allocations of server threads. Load generator threads are not counted.
+std::atomic<uint64_t> allocations{0};
+thread_local bool is_client = false;
+
+void *operator new(std::size_t size)
+{
+  if (!is_client) allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+const int port = 3050;
+const char public_dir[] = "/e2e_public";
+const std::size_t small_file = 1024;
+const std::size_t large_file = 1024 * 1024;
+const std::size_t large_body = 256 * 1024;
+
+struct scenario
+{
+  const char *name;
+  const char *path;
+  bool keep_alive;
+  int requests; // all threads, before --scale
+};
+
+const scenario scenarios[] = {
+    {"static_small", "/small.txt", true, 20000},
+    {"static_large", "/large.bin", true, 400},
+    {"param_route", "/users/42", true, 20000},
+    {"json", "/api/user", true, 20000},
+    {"large_body", "/large", true, 1000},
+    {"param_route_close", "/users/42", false, 3000},
+};
+
+struct endpoint
+{
+  const char *transport;
+  std::string local_path; // empty: tcp loopback
+};
+
+struct result
+{
+  std::string name;
+  std::string transport;
+  bool keep_alive = true;
+  long requests = 0;
+  long errors = 0;
+  double throughput = 0;
+  double p50_us = 0;
+  double p99_us = 0;
+  double p999_us = 0;
+  long rss_kb = 0;
+  double allocs_per_request = 0;
+};
+
+int parseLine(char *line)
+{
+  // This assumes that a digit will be found and the line ends in " Kb".
+  int i = strlen(line);
+  const char *p = line;
+  while (*p < '0' || *p > '9')
+    p++;
+  line[i - 3] = '\0';
+  i = atoi(p);
+  return i;
+}
+
+int getValue()
+{ // Note: this value is in KB!
+  FILE *file = fopen("/proc/self/status", "r");
+  int result = -1;
+  char line[128];
+
+  while (fgets(line, 128, file) != NULL)
+  {
+    if (strncmp(line, "VmRSS:", 6) == 0)
+    {
+      result = parseLine(line);
+      break;
+    }
+  }
+  fclose(file);
+  return result;
+}
+
+auto connect_to(const endpoint &ep) -> int
+{
+  if (!ep.local_path.empty())
+  {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, ep.local_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (::connect(fd, (const sockaddr *)&addr, sizeof(addr)) == -1)
+    {
+      ::close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  addr.sin_port = htons(port);
+
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  const int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  if (::connect(fd, (const sockaddr *)&addr, sizeof(addr)) == -1)
+  {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+auto write_all(const int fd, const std::string &data) -> bool
+{
+  std::size_t done = 0;
+  while (done < data.size())
+  {
+    const auto r = ::write(fd, data.data() + done, data.size() - done);
+    if (r <= 0) return false;
+    done += r;
+  }
+  return true;
+}
+
+// read one response, body is discarded. Returns status code, -1 on error.
+auto read_response(const int fd, std::string &head, std::vector<char> &buf) -> int
+{
+  head.clear();
+  std::size_t end = std::string::npos;
+  while (end == std::string::npos)
+  {
+    const auto r = ::read(fd, buf.data(), buf.size());
+    if (r <= 0) return -1;
+    head.append(buf.data(), r);
+    end = head.find("\r\n\r\n");
+  }
+
+  const auto cl = head.find("Content-Length: ");
+  const std::size_t length = cl == std::string::npos || cl > end ? 0 : std::atol(head.c_str() + cl + 16);
+  std::size_t body = head.size() - end - 4;
+  while (body < length)
+  {
+    const auto r = ::read(fd, buf.data(), std::min(buf.size(), length - body));
+    if (r <= 0) return -1;
+    body += r;
+  }
+
+  return head.size() > 12 ? std::atoi(head.c_str() + 9) : -1;
+}
+
+// closed loop: one request in flight per thread
+auto load(const endpoint &ep, const scenario &s, const int count, std::vector<double> &latencies) -> long
+{
+  is_client = true;
+
+  const std::string request = fmt::format(
+      "GET {} HTTP/1.1\r\nHost: localhost\r\n{}\r\n", s.path, s.keep_alive ? "" : "Connection: close\r\n");
+  std::string head;
+  std::vector<char> buf(64 * 1024);
+  long errors = 0;
+  int fd = -1;
+  for (int i = 0; i < count; ++i)
+  {
+    // connect is part of the request without keep-alive
+    const auto start = clock_type::now();
+    if (fd == -1) fd = connect_to(ep);
+    if (fd == -1)
+    {
+      ++errors;
+      continue;
+    }
+
+    const int status = write_all(fd, request) ? read_response(fd, head, buf) : -1;
+    latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - start).count());
+    if (status != 200) ++errors;
+
+    if (!s.keep_alive || status == -1)
+    {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+  if (fd != -1) ::close(fd);
+  return errors;
+}
+
+auto measure(const endpoint &ep, const scenario &s, const int threads, const double scale) -> result
+{
+  const int per_thread = std::max(1, static_cast<int>(s.requests * scale / threads));
+
+  std::vector<std::vector<double>> latencies(threads);
+  std::vector<long> errors(threads);
+  std::vector<std::thread> clients;
+
+  const auto allocated = allocations.load();
+  const auto start = clock_type::now();
+  for (int i = 0; i < threads; ++i)
+  {
+    latencies[i].reserve(per_thread);
+    clients.emplace_back([&, i]() { errors[i] = load(ep, s, per_thread, latencies[i]); });
+  }
+  for (auto &client : clients)
+  {
+    client.join();
+  }
+  const double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+  const auto allocated_total = allocations.load() - allocated;
+
+  std::vector<double> all;
+  for (const auto &l : latencies)
+  {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  const auto percentile = [&all](const double p) { return all.empty() ? 0 : all[(all.size() - 1) * p]; };
+
+  result r;
+  r.name = s.name;
+  r.transport = ep.transport;
+  r.keep_alive = s.keep_alive;
+  r.requests = all.size();
+  for (const auto e : errors)
+  {
+    r.errors += e;
+  }
+  r.throughput = all.size() / elapsed;
+  r.p50_us = percentile(0.5);
+  r.p99_us = percentile(0.99);
+  r.p999_us = percentile(0.999);
+  r.rss_kb = getValue();
+  r.allocs_per_request = all.empty() ? 0 : static_cast<double>(allocated_total) / all.size();
+  return r;
+}
+
+auto make_public() -> void
+{
+  const auto dir = std::filesystem::current_path().string() + public_dir;
+  std::filesystem::create_directories(dir);
+  std::ofstream(dir + "/small.txt") << std::string(small_file, 's');
+  std::ofstream(dir + "/large.bin") << std::string(large_file, 'l');
+}
+
+auto run_server(const endpoint &ep, const backend b, const int workers, const int threads, const double scale,
+    std::vector<result> &results) -> void
+{
+  const char *local_path = ep.local_path.empty() ? nullptr : ep.local_path.c_str();
+  auto options = http::options({port, "127.0.0.1", "Benchmark", public_dir, workers, 5, 32 * 1024 * 1024, b, local_path});
+  http::server app(&options);
+  http::middlewares::response response_middleware(&options);
+  app.add_middleware(&response_middleware);
+
+  const std::string large(large_body, 'b');
+  http::router router;
+  router.add("/users/\\d+", http::request::methods::Get,
+      [](http::request *req, http::response *res) { res->with_body(std::string_view(req->req.params.at(0))); });
+  router.add("/api/user", http::request::methods::Get,
+      [](http::request *, http::response *res)
+      {
+        res->with_added_header("Content-Type", "application/json;charset=utf-8");
+        miniJson::Json json = miniJson::Json::_object{
+            {"id", 42},
+            {"name", "Gordon Freeman"},
+            {"active", true},
+            {"roles", miniJson::Json::_array{"physicist", "admin"}},
+        };
+        res->with_json(&json);
+      });
+  router.add("/large", http::request::methods::Get,
+      [&large](http::request *, http::response *res) { res->with_body(std::string_view(large)); });
+  app.with_routers(&router);
+
+  std::thread server([&app]() { app.listen(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  for (const auto &s : scenarios)
+  {
+    results.push_back(measure(ep, s, threads, scale));
+  }
+
+  app.shutdown();
+  server.join();
+  if (local_path) ::unlink(local_path);
+}
+
+auto to_json(const std::vector<result> &results, const int threads, const int workers, const double scale)
+    -> std::string
+{
+  std::string out = fmt::format(
+      "{{\n  \"threads\": {},\n  \"workers\": {},\n  \"scale\": {},\n  \"scenarios\": [\n", threads, workers, scale);
+  for (std::size_t i = 0; i < results.size(); ++i)
+  {
+    const auto &r = results[i];
+    out += fmt::format("    {{\"name\": \"{}\", \"transport\": \"{}\", \"keep_alive\": {}, \"requests\": {}, "
+                       "\"errors\": {}, \"throughput\": {:.0f}, \"p50_us\": {:.1f}, \"p99_us\": {:.1f}, "
+                       "\"p999_us\": {:.1f}, \"rss_kb\": {}, \"allocs_per_request\": {:.2f}}}{}\n",
+        r.name, r.transport, r.keep_alive, r.requests, r.errors, r.throughput, r.p50_us, r.p99_us, r.p999_us,
+        r.rss_kb, r.allocs_per_request, i + 1 < results.size() ? "," : "");
+  }
+  out += "  ]\n}\n";
+  return out;
+}
+
+// value of "key" in a flat JSON object, empty when missing
+auto json_value(const std::string &object, const std::string &key) -> std::string
+{
+  const auto found = object.find("\"" + key + "\"");
+  if (found == std::string::npos) return "";
+
+  auto begin = object.find(':', found) + 1;
+  while (begin < object.size() && object[begin] == ' ')
+    ++begin;
+  if (object[begin] == '"') return object.substr(begin + 1, object.find('"', begin + 1) - begin - 1);
+
+  const auto end = object.find_first_of(",}", begin);
+  return object.substr(begin, end - begin);
+}
+
+// Metrics present in a baseline scenario are checked: throughput may drop and
+// latency may grow by timing tolerance, RSS by tolerance at most. Allocations
+// per request may not grow by a whole allocation.
+// Connection setup is a part of allocations per request, so the baseline is only
+// comparable with a run of the same threads, workers and scale.
+auto compare(const std::string &path, const std::vector<result> &results, const double tolerance,
+    const double timing_tolerance, const int threads, const int workers, const double scale) -> int
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    std::cerr << "baseline not found: " << path << std::endl;
+    return 1;
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  const std::string baseline = ss.str();
+
+  const auto header = baseline.substr(0, baseline.find("\"scenarios\""));
+  const auto differs = [&header](const char *key, const double actual)
+  {
+    const auto value = json_value(header, key);
+    return !value.empty() && std::atof(value.c_str()) != actual;
+  };
+  if (differs("threads", threads) || differs("workers", workers) || differs("scale", scale))
+  {
+    std::cerr << "baseline " << path << " is recorded with other --threads, --workers or --scale" << std::endl;
+    return 1;
+  }
+
+  int regressions = 0;
+  std::size_t pos = baseline.find("\"scenarios\"");
+  while ((pos = baseline.find('{', pos)) != std::string::npos)
+  {
+    const auto end = baseline.find('}', pos);
+    const auto object = baseline.substr(pos, end - pos + 1);
+    pos = end;
+
+    const auto name = json_value(object, "name");
+    const auto transport = json_value(object, "transport");
+    const auto found = std::find_if(results.begin(), results.end(),
+        [&](const result &r) { return r.name == name && r.transport == transport; });
+    if (found == results.end()) continue;
+
+    const auto report = [&](const char *metric, const double actual, const double expected)
+    {
+      ++regressions;
+      std::cerr << "REGRESSION " << transport << "/" << name << " " << metric << ": " << actual << " (baseline "
+                << expected << ")" << std::endl;
+    };
+    const auto check = [&](const char *metric, const double actual, const bool higher_is_better, const double limit)
+    {
+      const auto value = json_value(object, metric);
+      if (value.empty()) return;
+
+      const double expected = std::atof(value.c_str());
+      const bool regressed = higher_is_better ? actual < expected * (1 - limit)
+                                              : actual > expected * (1 + limit) + 0.05;
+      if (regressed) report(metric, actual, expected);
+    };
+    check("throughput", found->throughput, true, timing_tolerance);
+    check("p50_us", found->p50_us, false, timing_tolerance);
+    check("p99_us", found->p99_us, false, timing_tolerance);
+    check("p999_us", found->p999_us, false, timing_tolerance);
+    check("rss_kb", found->rss_kb, false, tolerance);
+    check("errors", found->errors, false, tolerance);
+
+    // whole allocations per request: the fraction is connection setup spread
+    // over the requests and varies between runs
+    const auto allocs = json_value(object, "allocs_per_request");
+    const double expected_allocs = std::atof(allocs.c_str());
+    if (!allocs.empty() && std::floor(found->allocs_per_request) > std::floor(expected_allocs))
+    {
+      report("allocs_per_request", found->allocs_per_request, expected_allocs);
+    }
+  }
+  return regressions;
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+  // the caller and the server main thread are not measured
+  is_client = true;
+  utils::Logger::set_level(utils::LogLevel::WARN);
+
+  utils::args args(argc, argv);
+  const auto option = [&args](const char *key, const char *fallback)
+  {
+    const auto value = args.find_option(key);
+    return value.empty() ? std::string(fallback) : value;
+  };
+  const int threads = std::atoi(option("--threads", "4").c_str());
+  const int workers = std::atoi(option("--workers", "2").c_str());
+  const double scale = std::atof(option("--scale", "1").c_str());
+  const double tolerance = std::atof(option("--tolerance", "0.1").c_str());
+  const double timing_tolerance = std::atof(option("--timing-tolerance", "0.3").c_str());
+  const auto transport = option("--transport", "all");
+  const auto b = option("--backend", "epoll") == "uring" ? backend::uring : backend::epoll;
+
+  make_public();
+
+  std::vector<result> results;
+  if (transport == "all" || transport == "tcp") run_server({"tcp", ""}, b, workers, threads, scale, results);
+  if (transport == "all" || transport == "unix")
+  {
+    const endpoint ep{"unix", fmt::format("/tmp/srv_e2e_{}.sock", getpid())};
+    run_server(ep, b, workers, threads, scale, results);
+  }
+
+  std::filesystem::remove_all(std::filesystem::current_path().string() + public_dir);
+
+  const auto json = to_json(results, threads, workers, scale);
+  std::cout << json;
+
+  const auto out = args.find_option("--out");
+  if (!out.empty()) std::ofstream(out) << json;
+
+  long errors = 0;
+  for (const auto &r : results)
+  {
+    errors += r.errors;
+  }
+
+  const auto baseline = args.find_option("--baseline");
+  const int regressions =
+      baseline.empty() ? 0 : compare(baseline, results, tolerance, timing_tolerance, threads, workers, scale);
+
+  return errors == 0 && regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <http/middlewares/response.h++>
+#include <http/options.h++>
+#include <http/server.h++>
+#include <io/uring/uring.h++>
+#include <iostream>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+using backend = io::event_loop::backend;
+
+const int threads = 4;
+const int connections = 64; // per thread
+const int rounds = 200;
+const char request[] = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+int parseLine(char *line)
+{
+  // This assumes that a digit will be found and the line ends in " Kb".
+  int i = strlen(line);
+  const char *p = line;
+  while (*p < '0' || *p > '9')
+    p++;
+  line[i - 3] = '\0';
+  i = atoi(p);
+  return i;
+}
+
+int getValue()
+{ // Note: this value is in KB!
+  FILE *file = fopen("/proc/self/status", "r");
+  int result = -1;
+  char line[128];
+
+  while (fgets(line, 128, file) != NULL)
+  {
+    if (strncmp(line, "VmRSS:", 6) == 0)
+    {
+      result = parseLine(line);
+      break;
+    }
+  }
+  fclose(file);
+  return result;
+}
+
+auto connect_to(const int port) -> int
+{
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  addr.sin_port = htons(port);
+
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  const int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  if (::connect(fd, (const sockaddr *)&addr, sizeof(addr)) == -1)
+  {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// read one response (head and Content-Length bytes of body)
+auto read_response(const int fd, std::string &in) -> bool
+{
+  in.clear();
+  char buf[4096];
+  while (true)
+  {
+    const auto head = in.find("\r\n\r\n");
+    if (head != std::string::npos)
+    {
+      const auto cl = in.find("Content-Length: ");
+      const std::size_t body = cl == std::string::npos ? 0 : std::atoi(in.c_str() + cl + 16);
+      if (in.size() >= head + 4 + body) return true;
+    }
+
+    const auto r = ::read(fd, buf, sizeof(buf));
+    if (r <= 0) return false;
+    in.append(buf, r);
+  }
+}
+
+// closed loop: every connection has one request in flight
+auto load(const int port, std::vector<double> &latencies) -> int
+{
+  std::vector<int> fds;
+  for (int i = 0; i < connections; ++i)
+  {
+    const int fd = connect_to(port);
+    if (fd != -1) fds.push_back(fd);
+  }
+
+  int failed = 0;
+  std::string in;
+  std::vector<clock_type::time_point> sent(fds.size());
+  for (int round = 0; round < rounds; ++round)
+  {
+    for (std::size_t i = 0; i < fds.size(); ++i)
+    {
+      sent[i] = clock_type::now();
+      if (::write(fds[i], request, sizeof(request) - 1) <= 0) ++failed;
+    }
+    for (std::size_t i = 0; i < fds.size(); ++i)
+    {
+      if (!read_response(fds[i], in))
+      {
+        ++failed;
+        continue;
+      }
+      latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - sent[i]).count());
+    }
+  }
+
+  for (const int fd : fds)
+  {
+    ::close(fd);
+  }
+  return failed + (connections - fds.size()) * rounds;
+}
+
+auto measure(const char *name, const backend b, const int port) -> int
+{
+  auto options = http::options({port, "127.0.0.1", "Benchmark", "/public", 2, 5, 0, b});
+  http::server app(&options);
+  http::middlewares::response response_middleware(&options);
+  app.add_middleware(&response_middleware);
+
+  http::router router;
+  router.add("/hello", http::request::methods::Get,
+      [](http::request *, http::response *res) { res->with_body("Hello, World!"); });
+  app.with_routers(&router);
+
+  std::thread server([&app]() { app.listen(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::vector<std::vector<double>> latencies(threads);
+  std::vector<std::thread> clients;
+  int failed = 0;
+  const auto start = clock_type::now();
+  for (int i = 0; i < threads; ++i)
+  {
+    latencies[i].reserve(connections * rounds);
+    clients.emplace_back(
+        [&latencies, &failed, port, i]()
+        {
+          const int f = load(port, latencies[i]);
+          if (f) __atomic_add_fetch(&failed, f, __ATOMIC_RELAXED);
+        });
+  }
+  for (auto &client : clients)
+  {
+    client.join();
+  }
+  const double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  app.shutdown();
+  server.join();
+
+  std::vector<double> all;
+  for (const auto &l : latencies)
+  {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  const auto percentile = [&all](const double p) { return all.empty() ? 0 : all[(all.size() - 1) * p]; };
+
+  std::stringstream ss;
+  ss << name;
+  ss << static_cast<long>(all.size() / elapsed) << " req/s ";
+  ss << "p50 " << percentile(0.5) << " μs ";
+  ss << "p99 " << percentile(0.99) << " μs ";
+  ss << " [" << getValue() << " Kb]";
+  std::cout << ss.rdbuf() << std::endl;
+
+  return failed;
+}
+
+auto main() -> int
+{
+  std::cout << "MEM: " << getValue() << " Kb" << std::endl;
+  std::cout << "CONNECTIONS: " << threads * connections << std::endl;
+
+  int failed = measure("epoll.......", backend::epoll, 3048);
+  failed += measure(io::uring::is_supported() ? "io_uring...." : "io_uring (epoll fallback)...", backend::uring, 3049);
+
+  std::cout << std::endl;
+  std::cout << "TOTAL" << std::endl;
+  std::cout << std::endl;
+  std::cout << "requests: " << 2 * threads * connections * rounds << std::endl;
+  std::cout << "failed:   " << failed << std::endl;
+  std::cout << "MEM:   " << getValue() << " Kb" << std::endl;
+
+  return failed == 0 ? 0 : 1;
+}
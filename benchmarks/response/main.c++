@@ -1,13 +1,37 @@
+#include <atomic>
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <http/response.h++>
 #include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
 
 const int requests = 100000;
 using response = ::http::response;
 
+// every heap allocation of the process is counted
+static std::atomic<std::size_t> allocations{0};
+
+void *operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
 int parseLine(char *line)
 {
   // This assumes that a digit will be found and the line ends in " Kb".
@@ -38,34 +62,67 @@ int getValue()
   return result;
 }
 
-auto main() -> int
+template<typename F>
+auto measure(const char *name, F &&fn) -> void
 {
-  std::cout << "MEM: " << getValue() << " Kb" << std::endl;
-
-  const char *phrase = "Benchmark";
+  const auto allocations_before = allocations.load();
   auto start = std::chrono::high_resolution_clock::now();
   for (int i = 0; i < requests; ++i)
   {
-    http::response res{200, "OK"};
-    res.with_added_header("Server", phrase);
-    res.with_added_header("Content-Type", "text/html;charset=utf-8");
-    res.with_body({'t', 'e', 's', 't'});
-    auto msg = res.get_message();
+    fn();
   }
   auto stop = std::chrono::high_resolution_clock::now();
+  const auto allocated = allocations.load() - allocations_before;
 
   double elapsed_micro = std::chrono::duration<double, std::micro>(stop - start).count();
   std::stringstream ss;
+  ss << name;
   ss << elapsed_micro / requests << " μs/res ";
+  ss << static_cast<double>(allocated) / requests << " alloc/res ";
   ss << " [" << getValue() << " Kb]";
 
   std::cout << ss.rdbuf() << std::endl;
+}
+
+auto main() -> int
+{
+  std::cout << "MEM: " << getValue() << " Kb" << std::endl;
+
+  const char *phrase = "Benchmark";
+  const std::string server = std::string("Server: ") + phrase + "\r\n";
+  std::size_t checksum = 0;
+
+  // new response per request, head and body in one string
+  measure("get_message.......",
+      [&]()
+      {
+        http::response res{200, "OK"};
+        res.with_added_header("Server", phrase);
+        res.with_added_header("Content-Type", "text/html;charset=utf-8");
+        res.with_body("test");
+        checksum += std::strlen(res.get_message());
+      });
+
+  // reactor path: response and head buffer reused by the connection
+  http::response res{200, "OK"};
+  std::string head;
+  measure("serialize (reused)",
+      [&]()
+      {
+        res.reset();
+        head.clear();
+        res.with_raw_header(server);
+        res.with_added_header("Content-Type", "text/html;charset=utf-8");
+        res.with_body("test");
+        res.serialize(head);
+        checksum += head.size() + res.get_body_view().size();
+      });
 
   std::cout << std::endl;
   std::cout << "TOTAL" << std::endl;
   std::cout << std::endl;
-  std::cout << "RES: " << requests << std::endl;
+  std::cout << "RES: " << requests * 2 << std::endl;
   std::cout << "MEM: " << getValue() << " Kb" << std::endl;
 
-  return 0;
+  return checksum > 0 ? 0 : 1;
 }
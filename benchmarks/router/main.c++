@@ -5,6 +5,7 @@
 #include <iostream>
 #include <ostream>
 #include <ratio>
+#include <sstream>
 #include <string>
 #include <utils/thread_pool.h++>
 #include <vector>
@@ -49,23 +50,12 @@ auto find_longest_url_size(const std::vector<std::string> *items) -> int
   return *max_element(sizes.begin(), sizes.end());
 }
 
-int main()
+auto make_router(::http::router &router, const int routes_count) -> void
 {
-  std::cout << "MEM: " << getValue() << " Kb" << std::endl;
-
-  const int requests = 1000;
   using request = ::http::request;
   using response = ::http::response;
   using method = request::methods;
 
-  utils::thread_pool thread_pool;
-  ::http::router router;
-
-  std::vector<std::string> urls = {
-      "/catalog/women/item/34", "/", "/articles/entry", "/not-found", "/blog/regex", "/1/2/3/4"};
-
-  const auto longest_url = find_longest_url_size(&urls);
-
   router.add("/", method::Get,
       [](request *req, response *res) {
 
@@ -91,39 +81,82 @@ int main()
 
       });
 
-  for (std::string &url : urls)
+  // filler: static, typed and regex routes in equal parts
+  for (int i = 0; i < routes_count; ++i)
   {
-    auto ft = thread_pool.enqueue(
-        [&router, &url, longest_url]()
-        {
-          auto start = std::chrono::high_resolution_clock::now();
-          for (int i = 0; i < requests; i++)
-          {
-            router.match(url.c_str());
-          }
-          auto stop = std::chrono::high_resolution_clock::now();
-          double elapsed_micro = std::chrono::duration<double, std::micro>(stop - start).count();
-          std::stringstream ss;
-          ss << url;
-          for (int i = 0; i < longest_url + 3 - url.size(); ++i)
-          {
-            if (longest_url + 3 == i) continue;
-            ss << ".";
-          }
-
-          ss << elapsed_micro / requests << " μs/req ";
-          ss << " [" << getValue() << " Kb]";
+    std::string url;
+    switch (i % 3)
+    {
+    case 0: url = "/static/r" + std::to_string(i) + "/page"; break;
+    case 1: url = "/users" + std::to_string(i) + "/{id:int}"; break;
+    case 2: url = "/posts" + std::to_string(i) + "/{slug:[a-z-]+}"; break;
+    }
+    router.add(url.c_str(), method::Get,
+        [](request *, response *) {
 
-          std::cout << ss.rdbuf() << std::endl;
         });
-    ft.wait();
+  }
+}
+
+int main()
+{
+  std::cout << "MEM: " << getValue() << " Kb" << std::endl;
+
+  const int requests = 100000;
+  using method = ::http::request::methods;
+
+  utils::thread_pool thread_pool;
+
+  std::vector<std::string> urls = {"/catalog/women/item/34", "/", "/articles/entry", "/not-found", "/blog/regex",
+      "/1/2/3/4", "/users1/42", "/posts2/long-slug?page=2"};
+  const std::vector<int> routes_counts = {10, 100, 1000};
+
+  const auto longest_url = find_longest_url_size(&urls);
+
+  for (const auto routes_count : routes_counts)
+  {
+    ::http::router router;
+    make_router(router, routes_count);
+
+    std::cout << std::endl;
+    std::cout << "ROUTES: " << router.get_size() << std::endl;
+
+    for (std::string &url : urls)
+    {
+      auto ft = thread_pool.enqueue(
+          [&router, &url, longest_url]()
+          {
+            ::http::request::params_map params;
+            int matched = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < requests; i++)
+            {
+              if (router.match(url, method::Get, params)) ++matched;
+            }
+            auto stop = std::chrono::high_resolution_clock::now();
+            double elapsed_micro = std::chrono::duration<double, std::micro>(stop - start).count();
+            std::stringstream ss;
+            ss << url;
+            for (std::size_t i = url.size(); i < static_cast<std::size_t>(longest_url) + 3; ++i)
+            {
+              ss << ".";
+            }
+
+            ss << elapsed_micro / requests << " μs/req ";
+            ss << (matched ? "hit " : "miss");
+            ss << " [" << getValue() << " Kb]";
+
+            std::cout << ss.rdbuf() << std::endl;
+          });
+      ft.wait();
+    }
+
+    router.shutdown();
   }
 
   std::cout << std::endl;
   std::cout << "TOTAL" << std::endl;
   std::cout << std::endl;
-  std::cout << "requests: " << requests * urls.size() << std::endl;
+  std::cout << "requests: " << requests * urls.size() * routes_counts.size() << std::endl;
   std::cout << "MEM:   " << getValue() << " Kb" << std::endl;
-
-  router.shutdown();
 }
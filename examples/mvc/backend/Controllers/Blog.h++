@@ -43,7 +43,7 @@ namespace Controllers
         return *res;
       }
 
-      const int id = atoi(params[0].c_str());
+      const int id = atoi(std::string(params[0]).c_str());
       auto article = this->model->find_one(id);
       if (article.size() <= 0)
       {
@@ -31,7 +31,7 @@ int main(int argc, char *argv[])
 
   Blog blog;
   router.add("/blog", method::Get, CONTROLLER(Blog::list, blog));
-  router.add("/blog/\\d+", method::Get, CONTROLLER(Blog::entry, blog));
+  router.add("/blog/{id:int}", method::Get, CONTROLLER(Blog::entry, blog));
 
   app.with_routers(&router);
 
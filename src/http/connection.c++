@@ -0,0 +1,102 @@
+#include "connection.h++"
+
+#include "request.h++"
+
+namespace http
+{
+  connection::connection(const int fd, const uint64_t id)
+      : fd_(fd)
+      , id_(id)
+      , state_(states::reading)
+      , error_(0)
+      , in_()
+      , begin_(0)
+      , head_size_(0)
+      , body_size_(0)
+      , keep_alive_(true)
+      , eof_(false)
+      , parser_()
+      , response_(200, "OK")
+      , head_()
+      , out_()
+      , deadline_(clock::now())
+  {
+  }
+
+  auto connection::feed(const char *data, const std::size_t size) -> bool
+  {
+    if (in_.size() - begin_ > INPUT_LIMIT) return false;
+
+    // compact buffer when the consumed part is the bigger one
+    if (begin_ > 0 && begin_ * 2 >= in_.size())
+    {
+      in_.erase(0, begin_);
+      begin_ = 0;
+    }
+
+    in_.append(data, size);
+    return true;
+  }
+
+  auto connection::next_request() -> std::string_view
+  {
+    if (state_ == states::error) return {};
+
+    // empty lines between pipelined requests are allowed (RFC 7230 3.5)
+    if (head_size_ == 0)
+    {
+      while (begin_ < in_.size() && (in_[begin_] == '\r' || in_[begin_] == '\n'))
+        ++begin_;
+    }
+
+    const std::string_view buf(in_.data() + begin_, in_.size() - begin_);
+
+    // parser resumes from the last complete line, once the head is complete
+    // the call only rebases views to the current buffer
+    const auto r = parser_.parse(buf.data(), buf.size());
+    if (r == request_parser::result::error) return fail(parser_.get_error());
+    if (r == request_parser::result::partial)
+    {
+      if (buf.size() > HEADER_LIMIT) return fail(431);
+      return {};
+    }
+
+    if (head_size_ == 0)
+    {
+      head_size_ = parser_.get_head_size();
+      body_size_ = parser_.get_content_length();
+      keep_alive_ = parser_.is_keep_alive();
+      if (head_size_ > HEADER_LIMIT) return fail(431);
+      if (body_size_ > BODY_LIMIT) return fail(413);
+      if (request::find_method(parser_.get_method()) == request::methods::Unknown) return fail(501);
+    }
+
+    if (buf.size() < head_size_ + body_size_) return {};
+
+    if (state_ == states::reading) state_ = states::ready;
+    return buf.substr(0, head_size_ + body_size_);
+  }
+
+  auto connection::consume() -> void
+  {
+    begin_ += head_size_ + body_size_;
+    if (begin_ >= in_.size())
+    {
+      in_.clear();
+      begin_ = 0;
+    }
+
+    head_size_ = 0;
+    body_size_ = 0;
+    parser_.reset();
+    if (state_ == states::ready) state_ = states::reading;
+  }
+
+  auto connection::fail(const int code) -> std::string_view
+  {
+    error_ = code;
+    state_ = states::error;
+    keep_alive_ = false;
+    return {};
+  }
+} // namespace http
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "request_parser.h++"
+#include "response.h++"
+#include "static_files.h++"
+
+namespace http
+{
+  /**
+   * @brief      Client connection state.
+   *
+   * @details    Input is accumulated across wakeups until a whole request
+   *             (head + Content-Length bytes of body) has arrived. Several
+   *             requests in the buffer are served one by one (pipelining).
+   *             The response object and the head buffer are reused for every
+   *             request of the connection. Bytes the socket did not accept
+   *             are kept in the output until the socket is writable again,
+   *             no further request is served meanwhile.
+   */
+  class connection
+  {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    enum class states : uint8_t
+    {
+      reading = 0, ///< Waiting for more bytes of request
+      ready = 1,   ///< Complete request is in the buffer
+      closing = 2, ///< Connection must be closed after the current response
+      error = 3,   ///< Malformed request, see get_error()
+    };
+
+    // request head (request line + headers) limit
+    constexpr static std::size_t HEADER_LIMIT = 1024 * 64;
+    // request body limit
+    constexpr static std::size_t BODY_LIMIT = 1024 * 1024 * 8;
+    // unparsed input limit, pipelined requests wait behind the pending response
+    constexpr static std::size_t INPUT_LIMIT = HEADER_LIMIT + BODY_LIMIT;
+
+    /**
+     * Unsent part of the response: bytes queued by the event loop or copied
+     * bytes first, then the file range
+     */
+    struct output
+    {
+      bool queued = false;
+      std::string bytes;
+      std::size_t sent = 0;
+      static_files::file_ptr file;
+      off_t offset = 0;
+      std::size_t left = 0;
+    };
+
+  public:
+    connection(const int fd, const uint64_t id);
+
+    ~connection() = default;
+
+    /**
+     * @brief      Append received bytes to the input buffer
+     *
+     * @param[in]  data  The data
+     * @param[in]  size  The size
+     *
+     * @return     false when unparsed input is over INPUT_LIMIT, nothing is
+     *             appended
+     */
+    auto feed(const char *data, const std::size_t size) -> bool;
+
+    /**
+     * @brief      Cut next complete request from the input buffer.
+     *
+     * @return     Request bytes (head and body) or empty view if more data is
+     *             needed. View is valid until consume() or feed().
+     */
+    auto next_request() -> std::string_view;
+
+    /**
+     * @brief      Drop the request returned by next_request()
+     *
+     * @return     void
+     */
+    auto consume() -> void;
+
+    /**
+     * @brief      Connection may be reused for the next request (HTTP/1.1
+     *             default or Connection: keep-alive)
+     */
+    auto is_keep_alive() -> bool { return keep_alive_; }
+
+    auto get_state() -> states { return state_; }
+
+    auto set_state(const states s) -> void { state_ = s; }
+
+    /**
+     * @brief      Peer shut down its sending side, buffered requests are the
+     *             last ones
+     */
+    auto is_eof() -> bool { return eof_; }
+
+    auto set_eof() -> void { eof_ = true; }
+
+    /**
+     * @brief      Parsed head of the request returned by next_request()
+     */
+    auto get_parser() -> const request_parser & { return parser_; }
+
+    /**
+     * @brief      Status code of malformed request (400, 413, 431, 501)
+     */
+    auto get_error() -> int { return error_; }
+
+    auto get_response() -> http::response & { return response_; }
+
+    /**
+     * Buffer the response head is rendered into
+     */
+    auto get_head() -> std::string & { return head_; }
+
+    auto get_output() -> output & { return out_; }
+
+    /**
+     * Response is not written completely, wait for on_writable
+     */
+    auto has_output() -> bool { return out_.queued || out_.sent < out_.bytes.size() || out_.left > 0; }
+
+    /**
+     * Forget written output, buffers keep their capacity
+     */
+    auto clear_output() -> void
+    {
+      out_.queued = false;
+      out_.bytes.clear();
+      out_.sent = 0;
+      out_.file.reset();
+      out_.offset = 0;
+      out_.left = 0;
+    }
+
+    auto get_fd() -> int { return fd_; }
+
+    auto get_id() -> uint64_t { return id_; }
+
+    auto get_deadline() -> clock::time_point { return deadline_; }
+
+    /**
+     * @brief      Push idle deadline forward
+     */
+    auto touch(const clock::time_point now, const std::chrono::milliseconds timeout) -> void
+    {
+      deadline_ = now + timeout;
+    }
+
+  private:
+    auto fail(const int code) -> std::string_view;
+
+  private:
+    int fd_;
+    uint64_t id_;
+    states state_;
+    int error_;
+
+    std::string in_;
+    std::size_t begin_;     // first byte of the current request
+    std::size_t head_size_; // 0 while head is incomplete
+    std::size_t body_size_;
+    bool keep_alive_;
+    bool eof_;
+    request_parser parser_;
+
+    http::response response_;
+    std::string head_;
+    output out_;
+
+    clock::time_point deadline_;
+  };
+} // namespace http
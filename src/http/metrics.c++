@@ -0,0 +1,18 @@
+#include "metrics.h++"
+
+#include <string>
+#include <utils/metrics.h++>
+
+namespace http::metrics
+{
+  auto handler(http::request *, http::response *res) -> void
+  {
+    std::string body;
+    body.reserve(16 * 1024);
+    utils::metrics::registry::get().render(body);
+
+    res->with_status(200, "OK");
+    res->with_added_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    res->with_body(std::string_view(body));
+  }
+} // namespace http::metrics
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "request.h++"
+#include "response.h++"
+
+namespace http::metrics
+{
+  /**
+   * @brief      Route handler that renders server metrics in Prometheus
+   *             text format. Counters stay at zero unless the server is
+   *             built with SRV_METRICS.
+   *
+   * @code
+   *             router.add("/metrics", http::request::methods::Get, http::metrics::handler);
+   * @endcode
+   */
+  auto handler(http::request *req, http::response *res) -> void;
+} // namespace http::metrics
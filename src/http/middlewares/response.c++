@@ -1,29 +1,26 @@
 #include "response.h++"
 
 #include <cstring>
-#include <filesystem>
-#include <fstream>
 
-#include "../mime.h++"
 #include "http/request.h++"
 #include "http/response.h++"
 #include "http/router.h++"
-#include "http/stream.h++"
+#include "utils/metrics.h++"
 
 namespace http::middlewares
 {
   response::response(const options_interface *option)
-      : mime_("")
-      , options_(const_cast<options_interface *>(option))
+      : options_(const_cast<options_interface *>(option))
+      , router_(nullptr)
+      , files_()
   {
     if (!option) return;
-  }
 
-  response::~response()
-  {
-    mime_.clear();
+    files_ = std::make_unique<http::static_files>(options_->get_public_dir(), options_->get_file_cache());
   }
 
+  response::~response() = default;
+
   auto response::execute(http::request *req, response_interface &response) -> void
   {
     // validate request
@@ -31,28 +28,25 @@ namespace http::middlewares
     {
       const char *phrase = "Server error";
       response.with_status(500, phrase);
-      response.with_added_header("Content-Length", std::to_string(std::strlen(phrase)).c_str());
       response.with_body(phrase);
       return;
     }
 
+    // routes first: matching does not allocate nor touch the file system
+    const auto router = METRICS_TIMED(route, router_->match(req->req.uri, req->req.method, req->req.params));
+    const auto is_method_allowed = router && router_->is_method_allowed(router, req->req.method);
+
     // serve static files
-    const auto file = this->is_file_exist(req->req.uri.c_str());
-    if (file)
+    if (!is_method_allowed)
     {
-      response.with_status(200, "OK");
-      http::mime mime;
-      auto ext = std::filesystem::path(req->req.uri.c_str()).extension().string().erase(0, 1);
-      auto file_mime = mime.get_ext(ext);
-      mime_ = file_mime.mime.append(";charset=utf-8");
-      response.with_added_header("Content-Type", mime_.c_str());
-      const auto buffer = load_file(req->req.uri.c_str());
-      response.with_body(buffer);
-      return;
+      auto file = files_ ? files_->find(req->req.uri) : nullptr;
+      if (file)
+      {
+        serve_file(req, static_cast<http::response &>(response), std::move(file));
+        return;
+      }
     }
 
-    // handle routers
-    auto router = router_->match(req->req.uri.c_str());
     if (!router)
     {
       response.with_status(404, "Not Found");
@@ -61,50 +55,49 @@ namespace http::middlewares
     }
 
     // methods
-    const auto is_method_allowed = router_->is_method_allowed(router, req->req.method);
     if (!is_method_allowed)
     {
-      response.with_status(405, "Not Allowed");
+      response.with_status(405, "Method Not Allowed");
       return;
     }
 
-    req->req.params = router->params;
-    const auto headers = response.get_headers();
+    METRICS_ROUTE(router->index);
+    METRICS_TIME(handler);
     router->handler(const_cast<http::request *>(req), static_cast<http::response *>(&response));
   }
 
-  auto response::is_file_exist(const char *p) -> bool
-  {
-    std::string path(options_->get_public_dir());
-    path.append(p);
-
-    return std::filesystem::exists(path) && std::filesystem::is_regular_file(path);
-  }
-
-  auto response::load_file(const char *p) -> http::stream::buffer
+  auto response::serve_file(const http::request *req, http::response &response, http::static_files::file_ptr file)
+      -> void
   {
-    std::string path(options_->get_public_dir());
-    path.append(p);
-
-    const auto is_regular_file = std::filesystem::is_regular_file(path);
-    const auto is_file_exist = std::filesystem::exists(path);
-
-    if (!is_regular_file || !is_file_exist)
+    response.with_status(200, "OK");
+    response.with_added_header("Content-Type", file->content_type);
+    response.with_added_header("Last-Modified", file->last_modified.c_str());
+    response.with_added_header("ETag", file->etag.c_str());
+    response.with_added_header("Accept-Ranges", "bytes");
+
+    const auto if_none_match = req->get_header(http::header_id::if_none_match);
+    const auto if_modified_since = req->get_header(http::header_id::if_modified_since);
+    if (http::static_files::is_not_modified(*file, if_none_match, if_modified_since))
     {
-      return {};
+      response.with_status(304, "Not Modified");
+      return;
     }
 
-    std::ifstream file(path, std::ios::binary);
-    std::stringstream buf;
-    buf << file.rdbuf();
-    file.close();
+    off_t offset = 0;
+    std::size_t length = file->size;
+    const auto range = http::static_files::parse_range(
+        *file, req->get_header(http::header_id::range), req->get_header("If-Range"), offset, length);
 
-    http::stream::buffer stream_buf;
-    for (const auto &c : buf.str())
+    switch (range)
     {
-      stream_buf.push_back(c);
+    case http::static_files::range_result::unsatisfiable:
+      response.with_status(416, "Range Not Satisfiable");
+      response.with_added_header("Content-Range", file->range_unsatisfied.c_str());
+      return;
+    case http::static_files::range_result::partial: response.with_status(206, "Partial Content"); break;
+    case http::static_files::range_result::none: break;
     }
 
-    return stream_buf;
+    response.with_file(std::move(file), offset, length);
   }
 } // namespace http::middlewares
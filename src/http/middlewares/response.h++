@@ -1,10 +1,13 @@
 #pragma once
 
+#include <memory>
+
 #include "../middleware_interface.h++"
 #include "../options_interface.h++"
 #include "../response_interface.h++"
+#include "../response.h++"
 #include "../router.h++"
-#include "../stream.h++"
+#include "../static_files.h++"
 
 namespace http::middlewares
 {
@@ -20,14 +23,17 @@ namespace http::middlewares
   public:
     auto set_router(const http::router *router) -> void { this->router_ = const_cast<http::router *>(router); }
 
-  private:
-    auto is_file_exist(const char *p) -> bool;
+    auto get_static_files() -> http::static_files * { return files_.get(); }
 
-    auto load_file(const char *p) -> http::stream::buffer;
+  private:
+    /**
+     * Full file, range (206/416) or 304 for a valid conditional request
+     */
+    auto serve_file(const http::request *req, http::response &response, http::static_files::file_ptr file) -> void;
 
   private:
     options_interface *options_;
     http::router *router_;
-    std::string mime_;
+    std::unique_ptr<http::static_files> files_;
   };
 } // namespace http::middlewares
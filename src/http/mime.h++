@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace http
@@ -54,6 +55,29 @@ namespace http
       return MIME_DEFAULT;
     }
 
+    /**
+     * Content-Type header value (with charset) for the extension.
+     * The table is built once and shared between threads.
+     */
+    inline static auto content_type(const std::string &ext) -> const char *
+    {
+      static const auto table = []()
+      {
+        std::unordered_map<std::string, std::string> t;
+        mime db;
+        for (const auto &item : db.db_)
+        {
+          t.emplace(item.ext, item.mime + ";charset=utf-8");
+        }
+        return t;
+      }();
+
+      const auto found = table.find(ext);
+      if (found == table.end()) return table.at(MIME_DEFAULT.ext).c_str();
+
+      return found->second.c_str();
+    }
+
   private:
     std::vector<mime_type> db_;
   };
@@ -29,6 +29,16 @@ namespace http
 
     auto get_public_dir() -> const char * override { return data_.public_dir.c_str(); }
 
+    auto get_workers() -> int override { return data_.workers; }
+
+    auto get_keep_alive() -> int override { return data_.keep_alive; }
+
+    auto get_file_cache() -> std::size_t override { return data_.file_cache; }
+
+    auto get_event_loop() -> io::event_loop::backend override { return data_.event_loop; }
+
+    auto get_local_path() -> const char * override { return data_.local_path; }
+
   private:
     struct data
     {
@@ -36,6 +46,11 @@ namespace http
       const char *host;
       const char *name;
       std::string public_dir;
+      int workers = 0; // 0: one reactor per hardware thread
+      int keep_alive = 5; // idle timeout, seconds. 0: close after response
+      std::size_t file_cache = 1024 * 1024 * 32; // static files cache, bytes. 0: disabled
+      io::event_loop::backend event_loop = io::event_loop::backend::epoll;
+      const char *local_path = nullptr; // Unix socket instead of host:port
     } data_;
   };
 } // namespace http
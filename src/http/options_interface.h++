@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <io/event_loop.h++>
+
 namespace http
 {
   struct options_interface
@@ -11,5 +14,32 @@ namespace http
     virtual auto get_name() -> const char * = 0;
 
     virtual auto get_public_dir() -> const char * = 0;
+
+    /**
+     * Number of event loops (reactors). Zero means one per hardware thread.
+     */
+    virtual auto get_workers() -> int = 0;
+
+    /**
+     * Idle keep-alive connection timeout in seconds. Zero disables keep-alive.
+     */
+    virtual auto get_keep_alive() -> int = 0;
+
+    /**
+     * Memory limit of the static files cache in bytes. Zero disables the cache.
+     */
+    virtual auto get_file_cache() -> std::size_t = 0;
+
+    /**
+     * Event loop backend of the reactors. io_uring falls back to epoll when
+     * the kernel does not support it.
+     */
+    virtual auto get_event_loop() -> io::event_loop::backend = 0;
+
+    /**
+     * Unix socket path. When set, the server listens on it instead of host
+     * and port.
+     */
+    virtual auto get_local_path() -> const char * = 0;
   };
 } // namespace http
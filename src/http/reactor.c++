@@ -0,0 +1,435 @@
+#include "reactor.h++"
+
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <thread>
+#include <utils/logger.h++>
+#include <utils/metrics.h++>
+
+#include "response.h++"
+#include "server.h++"
+
+namespace http
+{
+  namespace
+  {
+    constexpr std::string_view CONNECTION_CLOSE = "Connection: close\r\n";
+    constexpr std::string_view CONNECTION_KEEP_ALIVE = "Connection: keep-alive\r\n";
+
+    // sendfile until done or EAGAIN, false on error
+    auto send_file(const int fd, const static_file &file, off_t &offset, std::size_t &left) -> bool
+    {
+      while (left > 0)
+      {
+        const auto r = ::sendfile(fd, file.fd, &offset, left);
+        if (r == -1)
+        {
+          if (errno == EINTR) continue;
+          return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        // file was truncated
+        if (r == 0) return false;
+
+        left -= r;
+        METRICS_ADD(bytes_out, r);
+      }
+      return true;
+    }
+  } // namespace
+
+  reactor::reactor(server *srv, const int id)
+      : server_(srv)
+      , id_(id)
+      , srv_(nullptr)
+      , loop_(nullptr)
+      , connections_()
+      , timers_()
+      , timeout_(std::chrono::seconds(IDLE_TIMEOUT_DEFAULT))
+      , keep_alive_(false)
+      , next_id_(0)
+  {
+    const int keep_alive = srv->get_options()->get_keep_alive();
+    if (keep_alive > 0)
+    {
+      keep_alive_ = true;
+      timeout_ = std::chrono::seconds(keep_alive);
+    }
+  }
+
+  reactor::~reactor() = default;
+
+  auto reactor::open(const char *host, const int port) -> bool
+  {
+    srv_ = io::inet_socket::make_tcp(host, port);
+    if (!srv_) return false;
+
+    srv_->open();
+    srv_->set_non_blocking();
+    srv_->reuse_addr(true);
+    srv_->reuse_port(true);
+    if (!srv_->bind() || !srv_->listen()) return false;
+
+    return open(srv_->get_fd());
+  }
+
+  auto reactor::open(const int master) -> bool
+  {
+    const auto backend = server_->get_options()->get_event_loop();
+    loop_ = io::event_loop::make(backend);
+    if (loop_->get_backend() != backend && id_ == 0) LOG_WARN("io_uring is not supported, reactors use epoll");
+
+    try
+    {
+      loop_->create();
+      // wait timeout drives the idle timers
+      loop_->set_timeout(timers_.get_tick().count());
+      loop_->register_master(master);
+    }
+    catch (std::runtime_error &e)
+    {
+      LOG_ERROR("Failed to initialize event loop: {}", e.what());
+      return false;
+    }
+
+    loop_->on_connection([this](int socket) { on_accept(socket); });
+
+    loop_->on_close(
+        [this](int socket)
+        {
+          if (connections_.erase(socket)) METRICS_ADD(connections, -1);
+        });
+
+    loop_->on_data([this](int socket, const char *data, std::size_t size) { on_data(socket, data, size); });
+
+    loop_->on_writable([this](int socket) { on_writable(socket); });
+
+    loop_->on_eof([this](int socket) { on_eof(socket); });
+
+    return true;
+  }
+
+  auto reactor::run(const bool pin) -> void
+  {
+    if (pin) pin_to_core();
+
+    while (server_->is_running())
+    {
+      try
+      {
+        loop_->wait();
+      }
+      catch (std::runtime_error &e)
+      {
+        LOG_ERROR("Exception during event loop wait: {}", e.what());
+      }
+
+      timers_.advance(connection::clock::now(), [this](const timer &t) { expire(t); });
+    }
+
+    while (!connections_.empty())
+    {
+      close(connections_.begin()->first);
+    }
+  }
+
+  auto reactor::pin_to_core() -> void
+  {
+    const auto cores = std::thread::hardware_concurrency();
+    if (cores == 0) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(id_ % cores, &set);
+    const int r = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (r != 0) LOG_WARN("Failed to pin reactor {} to core {}: {}", id_, id_ % cores, std::strerror(r));
+  }
+
+  auto reactor::on_accept(const int fd) -> void
+  {
+    auto conn = std::make_unique<connection>(fd, next_id_++);
+    conn->touch(connection::clock::now(), timeout_);
+    timers_.schedule({fd, conn->get_id()}, timeout_);
+    connections_[fd] = std::move(conn);
+    METRICS_ADD(accepted, 1);
+    METRICS_ADD(connections, 1);
+  }
+
+  auto reactor::on_data(const int fd, const char *data, const std::size_t size) -> void
+  {
+    const auto found = connections_.find(fd);
+    if (found == connections_.end()) return;
+
+    METRICS_ADD(bytes_in, size);
+    const auto conn = found->second.get();
+    conn->touch(connection::clock::now(), timeout_);
+    // pipelined requests pile up behind the pending response, the peer
+    // waits in the socket buffer until it is written
+    if (conn->has_output()) loop_->pause_read(fd);
+    if (!conn->feed(data, size))
+    {
+      close(fd);
+      return;
+    }
+    process(conn);
+  }
+
+  auto reactor::on_writable(const int fd) -> void
+  {
+    const auto found = connections_.find(fd);
+    if (found == connections_.end()) return;
+
+    const auto conn = found->second.get();
+    if (!conn->has_output()) return;
+
+    // queued bytes are written by the loop
+    conn->get_output().queued = false;
+    if (!flush(conn))
+    {
+      close(fd);
+      return;
+    }
+    conn->touch(connection::clock::now(), timeout_);
+    if (conn->has_output())
+    {
+      loop_->want_writable(fd);
+      return;
+    }
+
+    if (conn->get_state() == connection::states::closing)
+    {
+      close(fd);
+      return;
+    }
+
+    // pipelined requests waited for the response
+    loop_->resume_read(fd);
+    process(conn);
+  }
+
+  auto reactor::on_eof(const int fd) -> void
+  {
+    const auto found = connections_.find(fd);
+    if (found == connections_.end()) return;
+
+    const auto conn = found->second.get();
+    conn->set_eof();
+    // on_writable serves the rest once the output is written
+    if (!conn->has_output()) process(conn);
+  }
+
+  auto reactor::process(connection *conn) -> void
+  {
+    const int fd = conn->get_fd();
+    while (conn->get_state() != connection::states::closing)
+    {
+      // the next response waits until the current one is written
+      if (conn->has_output()) return;
+
+      const auto request = METRICS_TIMED(parse, conn->next_request());
+      if (conn->get_state() == connection::states::error)
+      {
+        conn->set_state(connection::states::closing);
+        if (!reply_error(conn) || !conn->has_output()) close(fd);
+        return;
+      }
+
+      if (request.empty())
+      {
+        // nothing more will come from a half-closed peer
+        if (conn->is_eof()) close(fd);
+        return;
+      }
+
+      if (!keep_alive_ || !conn->is_keep_alive() || !server_->is_running())
+      {
+        conn->set_state(connection::states::closing);
+      }
+
+      if (!reply(conn))
+      {
+        close(fd);
+        return;
+      }
+      conn->consume();
+    }
+
+    // closed after the output is written
+    if (!conn->has_output()) close(fd);
+  }
+
+  auto reactor::reply(connection *conn) -> bool
+  {
+    const bool closing = conn->get_state() == connection::states::closing;
+
+    const bool access_log = utils::Logger::is_access_log();
+    const auto start = access_log ? connection::clock::now() : connection::clock::time_point();
+
+    auto &res = conn->get_response();
+    res.reset();
+    server_->handle(conn->get_parser(), res);
+    // the peer reads no body after the head, the next response follows it
+    res.with_head_only(conn->get_parser().get_method() == "HEAD");
+    res.with_raw_header(closing ? CONNECTION_CLOSE : CONNECTION_KEEP_ALIVE);
+    METRICS_ADD(requests, 1);
+    METRICS_STATUS(res.get_status_code());
+
+    const bool sent = send(conn, res);
+    if (access_log)
+    {
+      const auto &parser = conn->get_parser();
+      const auto body = res.get_body_view().size() + res.get_file_length();
+      const auto bytes = conn->get_head().size() + (res.is_head_only() ? 0 : body);
+      const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(connection::clock::now() - start);
+      utils::Logger::access(parser.get_method(), parser.get_uri(), res.get_status_code(), bytes, elapsed);
+    }
+    return sent;
+  }
+
+  auto reactor::reply_error(connection *conn) -> bool
+  {
+    const int code = conn->get_error();
+
+    auto &res = conn->get_response();
+    res.reset();
+    res.with_status(code, "");
+    res.with_raw_header(server_->get_server_header());
+    res.with_raw_header(CONNECTION_CLOSE);
+    res.with_body(http::response::reason_phrase(code));
+    METRICS_ADD(requests, 1);
+    METRICS_STATUS(code);
+
+    return send(conn, res);
+  }
+
+  auto reactor::send(connection *conn, http::response &res) -> bool
+  {
+    const int fd = conn->get_fd();
+    auto &head = conn->get_head();
+    head.clear();
+    METRICS_TIMED(serialize, res.serialize(head));
+
+    // body: response bytes, cached file or file range for sendfile
+    std::string_view body = res.get_body_view();
+    const auto &file = res.get_file();
+    off_t offset = res.get_file_offset();
+    std::size_t left = res.get_file_length();
+    if (res.is_head_only())
+    {
+      body = {};
+      left = 0;
+    }
+    else if (file && file->is_in_memory())
+    {
+      body = {file->data.data() + offset, left};
+      left = 0;
+    }
+
+    iovec iov[2] = {{head.data(), head.size()}, {const_cast<char *>(body.data()), body.size()}};
+    const int count = body.empty() ? 1 : 2;
+
+    // last response of the connection, the loop may close it after the write
+    const std::size_t total = head.size() + body.size();
+    if (left == 0 && conn->get_state() == connection::states::closing &&
+        METRICS_TIMED(write, loop_->send_close(fd, iov, count)))
+    {
+      METRICS_ADD(bytes_out, total);
+      return true;
+    }
+
+    METRICS_TIME(write);
+    const auto written = loop_->send(fd, iov, count);
+    if (written < 0 && written != io::event_loop::QUEUED) return false;
+
+    auto &out = conn->get_output();
+    METRICS_ADD(bytes_out, written == io::event_loop::QUEUED ? static_cast<ssize_t>(total) : written);
+    if (written == io::event_loop::QUEUED)
+    {
+      // file range is sent when the loop reports the bytes written
+      out.queued = true;
+    }
+    else if (static_cast<std::size_t>(written) < total)
+    {
+      // socket is full, keep the rest until EPOLLOUT
+      const std::size_t sent = written;
+      if (sent < head.size()) out.bytes.append(head, sent);
+      const std::size_t body_sent = sent > head.size() ? sent - head.size() : 0;
+      out.bytes.append(body.substr(body_sent));
+    }
+    else if (left > 0 && !send_file(fd, *file, offset, left))
+    {
+      return false;
+    }
+
+    if (left > 0)
+    {
+      out.file = file;
+      out.offset = offset;
+      out.left = left;
+    }
+
+    if (!out.queued && conn->has_output()) loop_->want_writable(fd);
+    return true;
+  }
+
+  auto reactor::flush(connection *conn) -> bool
+  {
+    METRICS_TIME(write);
+    const int fd = conn->get_fd();
+    auto &out = conn->get_output();
+    while (out.sent < out.bytes.size())
+    {
+      const auto r = ::write(fd, out.bytes.data() + out.sent, out.bytes.size() - out.sent);
+      if (r == -1)
+      {
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+      }
+      out.sent += r;
+      METRICS_ADD(bytes_out, r);
+    }
+
+    if (out.left > 0)
+    {
+      if (!send_file(fd, *out.file, out.offset, out.left)) return false;
+      if (out.left > 0) return true;
+    }
+
+    conn->clear_output();
+    return true;
+  }
+
+  auto reactor::close(const int fd) -> void
+  {
+    try
+    {
+      loop_->unwatch(fd);
+    }
+    catch (std::runtime_error &e)
+    {
+      LOG_WARN("Failed to close connection fd={}: {}", fd, e.what());
+    }
+    if (connections_.erase(fd)) METRICS_ADD(connections, -1);
+  }
+
+  auto reactor::expire(const timer &t) -> void
+  {
+    const auto found = connections_.find(t.fd);
+    // connection is already closed, fd may be reused by a newer one
+    if (found == connections_.end() || found->second->get_id() != t.id) return;
+
+    const auto now = connection::clock::now();
+    const auto deadline = found->second->get_deadline();
+    if (deadline > now)
+    {
+      timers_.schedule(t, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now));
+      return;
+    }
+
+    LOG_DEBUG("Closing idle connection fd={}", t.fd);
+    close(t.fd);
+  }
+} // namespace http
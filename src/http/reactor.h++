@@ -0,0 +1,140 @@
+#pragma once
+
+#include <chrono>
+#include <io/event_loop.h++>
+#include <io/sockets/inet_socket.h++>
+#include <memory>
+#include <unordered_map>
+#include <utils/timer_wheel.h++>
+
+#include "connection.h++"
+
+namespace http
+{
+  class server;
+
+  /**
+   * @brief      One event loop of the server.
+   *
+   * @details    Every reactor owns a listen socket bound with SO_REUSEPORT and
+   *             its own event loop (epoll or io_uring), so the kernel spreads
+   *             new connections between reactors and a connection never
+   *             leaves the thread that accepted it. Idle connections are
+   *             closed by a timer wheel that is advanced after every wait.
+   *             Writes never block: what the socket did not accept (or the
+   *             loop queued) is finished on writable event.
+   */
+  class reactor
+  {
+  public:
+    reactor(server *srv, const int id);
+
+    ~reactor();
+
+    /**
+     * @brief      Open listen socket and create event loop
+     *
+     * @param[in]  host  The host
+     * @param[in]  port  The port
+     *
+     * @return     false on socket or event loop error
+     */
+    auto open(const char *host, const int port) -> bool;
+
+    /**
+     * @brief      Accept from a listen socket shared by all reactors (Unix
+     *             socket) and create event loop. Socket is owned by caller.
+     *
+     * @param[in]  master  The listen socket
+     *
+     * @return     false on event loop error
+     */
+    auto open(const int master) -> bool;
+
+    /**
+     * @brief      Run event loop until server is stopped. Blocks the caller.
+     *
+     * @param[in]  pin   Bind calling thread to the cpu core (id % cores)
+     *
+     * @return     void
+     */
+    auto run(const bool pin) -> void;
+
+    auto get_id() -> int { return id_; }
+
+    auto get_connections() -> std::size_t { return connections_.size(); }
+
+  private:
+    struct timer
+    {
+      int fd;
+      uint64_t id;
+    };
+
+    auto pin_to_core() -> void;
+
+    auto on_accept(const int fd) -> void;
+
+    auto on_data(const int fd, const char *data, const std::size_t size) -> void;
+
+    /**
+     * @brief      Resume pending output, then serve buffered requests
+     */
+    auto on_writable(const int fd) -> void;
+
+    /**
+     * @brief      Peer sends no more requests, answer buffered ones and close
+     */
+    auto on_eof(const int fd) -> void;
+
+    /**
+     * @brief      Serve all complete requests of the connection
+     */
+    auto process(connection *conn) -> void;
+
+    /**
+     * @brief      Run current request of the connection through the server
+     *             and write response
+     *
+     * @return     false on write error
+     */
+    auto reply(connection *conn) -> bool;
+
+    auto reply_error(connection *conn) -> bool;
+
+    /**
+     * @brief      Write head and body with one writev or hand them to the
+     *             event loop (file range goes with sendfile), the part socket
+     *             did not take is kept in the connection output
+     *
+     * @return     false on write error
+     */
+    auto send(connection *conn, http::response &res) -> bool;
+
+    /**
+     * @brief      Write connection output until done or EAGAIN
+     *
+     * @return     false on write error
+     */
+    auto flush(connection *conn) -> bool;
+
+    auto close(const int fd) -> void;
+
+    auto expire(const timer &t) -> void;
+
+  private:
+    constexpr static const int IDLE_TIMEOUT_DEFAULT = 5; // seconds, when keep-alive is disabled
+
+    server *server_;
+    int id_;
+
+    std::unique_ptr<io::inet_socket> srv_;
+    std::unique_ptr<io::event_loop> loop_;
+
+    std::unordered_map<int, std::unique_ptr<connection>> connections_;
+    utils::timer_wheel<timer> timers_;
+    std::chrono::milliseconds timeout_;
+    bool keep_alive_;
+    uint64_t next_id_;
+  };
+} // namespace http
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <array>
+#include <stdexcept>
 #include <stl/string/ws_string.h++>
+#include <string_view>
 #include <vector>
 
+#include "request_parser.h++"
+
 namespace http
 {
   struct request
@@ -17,21 +22,64 @@ namespace http
       Delete,
       Trace,
       Connect,
+      Unknown, ///< not implemented, answered with 501
     };
 
-    using params_map = std::vector<std::string>;
+    /**
+     * Route params captured by the router. Values are views into the request
+     * uri and are valid while the request is handled.
+     */
+    struct params_map
+    {
+      constexpr static std::size_t CAPACITY = 16;
+
+      /**
+       * false when CAPACITY params are captured, the value is dropped
+       */
+      auto push_back(std::string_view value) -> bool
+      {
+        if (size_ == CAPACITY) return false;
+        items_[size_++] = value;
+        return true;
+      }
+
+      auto pop_back() -> void { --size_; }
+
+      auto clear() -> void { size_ = 0; }
+
+      auto size() const -> std::size_t { return size_; }
+
+      auto empty() const -> bool { return size_ == 0; }
+
+      auto operator[](const std::size_t i) const -> std::string_view { return items_[i]; }
+
+      auto at(const std::size_t i) const -> std::string_view
+      {
+        if (i >= size_) throw std::out_of_range("params_map::at");
+        return items_[i];
+      }
+
+      auto begin() const -> const std::string_view * { return items_.data(); }
+
+      auto end() const -> const std::string_view * { return items_.data() + size_; }
+
+    private:
+      std::array<std::string_view, CAPACITY> items_{};
+      std::size_t size_ = 0;
+    };
 
   public:
     struct http_request
     {
       methods method;
-      std::string uri;
+      std::string_view uri; // into the connection buffer, valid while the request is handled
       float http_ver;
       params_map params;
     } req;
 
     request()
         : input_("")
+        , parser_(nullptr)
     {
     }
 
@@ -76,7 +124,8 @@ namespace http
       }
 
       req.method = get_method(meth);
-      req.uri = get_uri(uri);
+      uri_ = get_uri(uri);
+      req.uri = uri_;
       req.http_ver = get_version(version_raw);
 
       if (!validate_request(&req)) return nullptr;
@@ -84,25 +133,92 @@ namespace http
       return &req;
     }
 
+    /**
+     * Fill request from parsed head. Headers and body stay in the parser
+     * (connection buffer) and are available while request is handled.
+     */
+    inline auto parse(const request_parser &parser) -> const http_request *
+    {
+      parser_ = &parser;
+
+      req.method = find_method(parser.get_method());
+      req.uri = parser.get_uri();
+      req.http_ver = parser.get_minor_version() == 0 ? 1.0f : 1.1f;
+      req.params.clear();
+
+      if (!validate_request(&req)) return nullptr;
+
+      return &req;
+    }
+
+    /**
+     * Header value of the request, empty if header is missing
+     */
+    inline auto get_header(const header_id id) const -> std::string_view
+    {
+      return parser_ ? parser_->get_header(id) : std::string_view{};
+    }
+
+    inline auto get_header(std::string_view name) const -> std::string_view
+    {
+      return parser_ ? parser_->get_header(name) : std::string_view{};
+    }
+
+    inline auto get_body() const -> std::string_view { return parser_ ? parser_->get_body() : std::string_view{}; }
+
+    /**
+     * Method token to enum. Methods are case-sensitive (RFC 7231 4.1), other
+     * spellings go through the slower get_method().
+     */
+    inline static auto find_method(std::string_view m) -> methods
+    {
+      switch (m.size())
+      {
+      case 3:
+        if (m == "GET") return methods::Get;
+        if (m == "PUT") return methods::Put;
+        break;
+      case 4:
+        if (m == "POST") return methods::Post;
+        break;
+      case 5:
+        if (m == "PATCH") return methods::Patch;
+        if (m == "TRACE") return methods::Trace;
+        break;
+      case 6:
+        if (m == "DELETE") return methods::Delete;
+        break;
+      case 7:
+        if (m == "OPTIONS") return methods::Options;
+        if (m == "CONNECT") return methods::Connect;
+        break;
+      default: break;
+      }
+
+      return get_method(m);
+    }
+
     inline static auto validate_request(const http_request *req) -> bool
     {
       return req->http_ver > 0 && !req->uri.empty();
     }
 
-    inline static auto get_method(const std::string &m) -> const methods
+    inline static auto get_method(std::string_view m) -> const methods
     {
-      auto str = ws_stl::to_upper(ws_stl::trim_string(m));
-
-      if (str == "GET") return methods::Get;
-      if (str == "POST") return methods::Post;
-      if (str == "PATCH") return methods::Patch;
-      if (str == "PUT") return methods::Put;
-      if (str == "OPTIONS") return methods::Options;
-      if (str == "DELETE") return methods::Delete;
-      if (str == "TRACE") return methods::Trace;
-      if (str == "CONNECT") return methods::Connect;
-
-      return methods::Get;
+      const auto str = ws_stl::trim_view(m);
+
+      if (ws_stl::iequals(str, "GET")) return methods::Get;
+      if (ws_stl::iequals(str, "POST")) return methods::Post;
+      if (ws_stl::iequals(str, "PATCH")) return methods::Patch;
+      if (ws_stl::iequals(str, "PUT")) return methods::Put;
+      if (ws_stl::iequals(str, "OPTIONS")) return methods::Options;
+      if (ws_stl::iequals(str, "DELETE")) return methods::Delete;
+      if (ws_stl::iequals(str, "TRACE")) return methods::Trace;
+      if (ws_stl::iequals(str, "CONNECT")) return methods::Connect;
+      // HEAD is routed as GET, the response is sent without the body
+      if (ws_stl::iequals(str, "HEAD")) return methods::Get;
+
+      return methods::Unknown;
     }
 
     inline static auto get_uri(const std::string &raw) -> const std::string { return ws_stl::trim_string(raw); }
@@ -141,6 +257,8 @@ namespace http
 
   private:
     std::string input_;
+    std::string uri_; // uri of parse(input)
+    const request_parser *parser_;
   };
 
 } // namespace http
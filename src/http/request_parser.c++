@@ -0,0 +1,290 @@
+#include "request_parser.h++"
+
+#include <charconv>
+#include <cstring>
+#include <stl/string/ws_string.h++>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace http
+{
+  namespace
+  {
+    struct known_header
+    {
+      std::string_view name;
+      header_id id;
+    };
+
+    constexpr known_header KNOWN_HEADERS[] = {
+        {"Host", header_id::host},
+        {"Connection", header_id::connection},
+        {"Content-Length", header_id::content_length},
+        {"Content-Type", header_id::content_type},
+        {"Transfer-Encoding", header_id::transfer_encoding},
+        {"User-Agent", header_id::user_agent},
+        {"Accept", header_id::accept},
+        {"Accept-Encoding", header_id::accept_encoding},
+        {"Accept-Language", header_id::accept_language},
+        {"Authorization", header_id::authorization},
+        {"Cache-Control", header_id::cache_control},
+        {"Cookie", header_id::cookie},
+        {"If-Modified-Since", header_id::if_modified_since},
+        {"If-None-Match", header_id::if_none_match},
+        {"Origin", header_id::origin},
+        {"Range", header_id::range},
+        {"Referer", header_id::referer},
+    };
+
+    inline auto trim(const char *&begin, const char *&end) -> void
+    {
+      while (begin < end && (*begin == ' ' || *begin == '\t'))
+        ++begin;
+      while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+        --end;
+    }
+  } // namespace
+
+  request_parser::request_parser()
+  {
+    reset();
+  }
+
+  auto request_parser::reset() -> void
+  {
+    base_ = nullptr;
+    state_ = result::partial;
+    error_ = 0;
+    pos_ = 0;
+    method_ = uri_ = version_ = {0, 0};
+    minor_ = 1;
+    headers_count_ = 0;
+    known_.fill(0);
+    head_size_ = 0;
+    content_length_ = 0;
+    keep_alive_ = true;
+  }
+
+  auto request_parser::parse(const char *buf, const std::size_t size) -> result
+  {
+    base_ = buf;
+    if (state_ != result::partial) return state_;
+
+    const char *end = buf + size;
+    const char *line = buf + pos_;
+    while (line < end)
+    {
+      const char *lf = find_char(line, end, '\n');
+      if (lf == end) break;
+
+      // bare LF is not allowed as a line terminator
+      if (lf == line || lf[-1] != '\r') return fail(400);
+      const char *line_end = lf - 1;
+
+      if (pos_ == 0)
+      {
+        if (!parse_request_line(line, line_end)) return fail(400);
+      }
+      else if (line == line_end)
+      {
+        head_size_ = lf + 1 - buf;
+        pos_ = head_size_;
+        state_ = result::complete;
+        return state_;
+      }
+      else if (!parse_header(line, line_end))
+      {
+        return state_;
+      }
+
+      line = lf + 1;
+      pos_ = line - buf;
+    }
+
+    return result::partial;
+  }
+
+  auto request_parser::get_header(const header_id id) const -> std::string_view
+  {
+    if (id == header_id::unknown || id >= header_id::count) return {};
+
+    const auto index = known_[static_cast<std::size_t>(id)];
+    if (index == 0) return {};
+
+    return view(headers_[index - 1].value);
+  }
+
+  auto request_parser::get_header(std::string_view name) const -> std::string_view
+  {
+    const auto id = lookup(name);
+    if (id != header_id::unknown) return get_header(id);
+
+    for (std::size_t i = 0; i < headers_count_; ++i)
+    {
+      if (ws_stl::iequals(view(headers_[i].name), name)) return view(headers_[i].value);
+    }
+    return {};
+  }
+
+  auto request_parser::get_header_at(const std::size_t i) const -> header
+  {
+    if (i >= headers_count_) return {{}, {}, header_id::unknown};
+
+    const auto &h = headers_[i];
+    return {view(h.name), view(h.value), h.id};
+  }
+
+  auto request_parser::lookup(std::string_view name) -> header_id
+  {
+    for (const auto &known : KNOWN_HEADERS)
+    {
+      if (known.name.size() != name.size()) continue;
+      if (ws_stl::iequals(known.name, name)) return known.id;
+    }
+    return header_id::unknown;
+  }
+
+  auto request_parser::find_char(const char *p, const char *end, const char c) -> const char *
+  {
+#if defined(__AVX2__)
+    const __m256i needle32 = _mm256_set1_epi8(c);
+    while (end - p >= 32)
+    {
+      const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+      const uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle32));
+      if (mask != 0) return p + __builtin_ctz(mask);
+      p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i needle16 = _mm_set1_epi8(c);
+    while (end - p >= 16)
+    {
+      const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      const uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle16));
+      if (mask != 0) return p + __builtin_ctz(mask);
+      p += 16;
+    }
+#endif
+    while (p < end && *p != c)
+      ++p;
+    return p;
+  }
+
+  auto request_parser::parse_request_line(const char *begin, const char *end) -> bool
+  {
+    const char *sp1 = find_char(begin, end, ' ');
+    if (sp1 == begin || sp1 == end) return false;
+
+    const char *uri = sp1 + 1;
+    const char *sp2 = find_char(uri, end, ' ');
+    if (sp2 == uri || sp2 == end) return false;
+
+    const char *version = sp2 + 1;
+    const std::string_view v(version, end - version);
+    if (v.size() < 6 || v.substr(0, 5) != "HTTP/") return false;
+
+    method_ = make_span(begin, sp1);
+    uri_ = make_span(uri, sp2);
+    version_ = make_span(version, end);
+
+    // HTTP/1.0 closes connection by default
+    minor_ = v == "HTTP/1.0" ? 0 : 1;
+    keep_alive_ = minor_ != 0;
+
+    return true;
+  }
+
+  auto request_parser::parse_header(const char *begin, const char *end) -> bool
+  {
+    // obsolete line folding (RFC 7230 3.2.4)
+    if (*begin == ' ' || *begin == '\t')
+    {
+      fail(400);
+      return false;
+    }
+
+    const char *colon = find_char(begin, end, ':');
+    if (colon == end || colon == begin)
+    {
+      fail(400);
+      return false;
+    }
+
+    if (headers_count_ == MAX_HEADERS)
+    {
+      fail(431);
+      return false;
+    }
+
+    // no whitespace between name and colon (RFC 9112 5.1), a proxy may
+    // read "Content-Length :" as another header than we do
+    const char *name_end = colon;
+    if (name_end[-1] == ' ' || name_end[-1] == '\t')
+    {
+      fail(400);
+      return false;
+    }
+
+    const char *value = colon + 1;
+    const char *value_end = end;
+    trim(value, value_end);
+
+    const std::string_view name(begin, name_end - begin);
+    const std::string_view val(value, value_end - value);
+    const auto id = lookup(name);
+
+    switch (id)
+    {
+    case header_id::content_length:
+    {
+      std::size_t size = 0;
+      const auto r = std::from_chars(val.data(), val.data() + val.size(), size);
+      if (val.empty() || r.ec != std::errc() || r.ptr != val.data() + val.size())
+      {
+        fail(400);
+        return false;
+      }
+      // repeated with another value, the body size is ambiguous (RFC 9112 6.3)
+      if (known_[static_cast<std::size_t>(id)] != 0 && size != content_length_)
+      {
+        fail(400);
+        return false;
+      }
+      content_length_ = size;
+      break;
+    }
+    case header_id::transfer_encoding:
+      // chunked request bodies are not supported, any other coding can not
+      // be decoded. Next to Content-Length the body size is ambiguous
+      // (RFC 9112 6.1, 6.3)
+      fail(known_[static_cast<std::size_t>(header_id::content_length)] == 0 && ws_stl::iequals(val, "chunked") ? 501
+                                                                                                              : 400);
+      return false;
+    case header_id::connection:
+      if (ws_stl::icontains(val, "close")) keep_alive_ = false;
+      if (ws_stl::icontains(val, "keep-alive")) keep_alive_ = true;
+      break;
+    default: break;
+    }
+
+    headers_[headers_count_] = {make_span(begin, name_end), make_span(value, value_end), id};
+    ++headers_count_;
+    if (id != header_id::unknown && known_[static_cast<std::size_t>(id)] == 0)
+    {
+      known_[static_cast<std::size_t>(id)] = static_cast<uint8_t>(headers_count_);
+    }
+
+    return true;
+  }
+
+  auto request_parser::fail(const int code) -> result
+  {
+    error_ = code;
+    state_ = result::error;
+    keep_alive_ = false;
+    return state_;
+  }
+} // namespace http
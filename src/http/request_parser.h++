@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace http
+{
+  /**
+   * Common request headers, resolved once while parsing
+   */
+  enum class header_id : uint8_t
+  {
+    unknown = 0,
+    host,
+    connection,
+    content_length,
+    content_type,
+    transfer_encoding,
+    user_agent,
+    accept,
+    accept_encoding,
+    accept_language,
+    authorization,
+    cache_control,
+    cookie,
+    if_modified_since,
+    if_none_match,
+    origin,
+    range,
+    referer,
+    count,
+  };
+
+  /**
+   * @brief      Single pass, zero-copy HTTP/1.x request head parser.
+   *
+   * @details    Parser works on the connection read buffer and never copies it:
+   *             all fields are string views. Positions are kept as offsets, so
+   *             a head that arrives split across reads is resumed from the last
+   *             complete line even if the buffer was reallocated in between.
+   *             Line ends are found with SSE2/AVX2 when available.
+   */
+  class request_parser
+  {
+  public:
+    enum class result : uint8_t
+    {
+      complete = 0, ///< Whole head is parsed
+      partial = 1,  ///< Need more bytes
+      error = 2,    ///< Malformed head, see get_error()
+    };
+
+    struct header
+    {
+      std::string_view name;
+      std::string_view value;
+      header_id id;
+    };
+
+    constexpr static std::size_t MAX_HEADERS = 64;
+
+  public:
+    request_parser();
+
+    ~request_parser() = default;
+
+    /**
+     * @brief      Parse head of the request which starts at buf. Call again
+     *             with the same (possibly moved and grown) request to resume.
+     *
+     * @param[in]  buf   Start of request
+     * @param[in]  size  Bytes available
+     *
+     * @return     parse result
+     */
+    auto parse(const char *buf, const std::size_t size) -> result;
+
+    /**
+     * @brief      Forget parsed request, parser is ready for the next one
+     *
+     * @return     void
+     */
+    auto reset() -> void;
+
+    auto get_method() const -> std::string_view { return view(method_); }
+
+    auto get_uri() const -> std::string_view { return view(uri_); }
+
+    auto get_version() const -> std::string_view { return view(version_); }
+
+    /**
+     * @brief      Protocol minor version: 0 for HTTP/1.0, 1 for HTTP/1.1
+     */
+    auto get_minor_version() const -> int { return minor_; }
+
+    /**
+     * @brief      Header value by id, empty view if header is missing
+     */
+    auto get_header(const header_id id) const -> std::string_view;
+
+    /**
+     * @brief      Header value by name (case insensitive), empty view if missing
+     */
+    auto get_header(std::string_view name) const -> std::string_view;
+
+    auto get_headers_size() const -> std::size_t { return headers_count_; }
+
+    auto get_header_at(const std::size_t i) const -> header;
+
+    /**
+     * @brief      Request body, valid once content_length bytes were received
+     */
+    auto get_body() const -> std::string_view { return {base_ + head_size_, content_length_}; }
+
+    /**
+     * @brief      Size of request line and headers including final CRLF
+     */
+    auto get_head_size() const -> std::size_t { return head_size_; }
+
+    auto get_content_length() const -> std::size_t { return content_length_; }
+
+    auto is_keep_alive() const -> bool { return keep_alive_; }
+
+    auto is_complete() const -> bool { return state_ == result::complete; }
+
+    /**
+     * @brief      Status code for malformed request (400, 431, 501)
+     */
+    auto get_error() const -> int { return error_; }
+
+    /**
+     * @brief      Resolve header name to id
+     */
+    static auto lookup(std::string_view name) -> header_id;
+
+    /**
+     * @brief      Position of first c in [p, end), or end. Vectorized.
+     */
+    static auto find_char(const char *p, const char *end, const char c) -> const char *;
+
+  private:
+    // offset/length of a field in the request buffer
+    struct span
+    {
+      uint32_t offset;
+      uint32_t size;
+    };
+
+    struct header_span
+    {
+      span name;
+      span value;
+      header_id id;
+    };
+
+    auto view(const span s) const -> std::string_view { return {base_ + s.offset, s.size}; }
+
+    auto make_span(const char *begin, const char *end) const -> span
+    {
+      return {static_cast<uint32_t>(begin - base_), static_cast<uint32_t>(end - begin)};
+    }
+
+    auto parse_request_line(const char *begin, const char *end) -> bool;
+
+    auto parse_header(const char *begin, const char *end) -> bool;
+
+    auto fail(const int code) -> result;
+
+  private:
+    const char *base_;
+    result state_;
+    int error_;
+    std::size_t pos_; // start of first not parsed line
+
+    span method_;
+    span uri_;
+    span version_;
+    int minor_;
+
+    std::array<header_span, MAX_HEADERS> headers_;
+    std::size_t headers_count_;
+    // index + 1 into headers_ for known headers, 0 if missing
+    std::array<uint8_t, static_cast<std::size_t>(header_id::count)> known_;
+
+    std::size_t head_size_;
+    std::size_t content_length_;
+    bool keep_alive_;
+  };
+} // namespace http
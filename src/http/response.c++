@@ -1,32 +1,120 @@
 #include "response.h++"
 
+#include <array>
+#include <cerrno>
+#include <charconv>
 #include <cstring> // strlen
+#include <fcntl.h>
 #include <filesystem>
-#include <fstream>
-
-#include "stream.h++"
+#include <strings.h> // strcasecmp
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace http
 {
-  stream stream_;
+  namespace
+  {
+    constexpr int CODES_SIZE = 600;
+
+    struct status
+    {
+      int code;
+      const char *reason;
+    };
+
+    constexpr status STATUSES[] = {
+        {100, "Continue"},
+        {101, "Switching Protocols"},
+        {200, "OK"},
+        {201, "Created"},
+        {202, "Accepted"},
+        {204, "No Content"},
+        {206, "Partial Content"},
+        {301, "Moved Permanently"},
+        {302, "Found"},
+        {303, "See Other"},
+        {304, "Not Modified"},
+        {307, "Temporary Redirect"},
+        {308, "Permanent Redirect"},
+        {400, "Bad Request"},
+        {401, "Unauthorized"},
+        {403, "Forbidden"},
+        {404, "Not Found"},
+        {405, "Method Not Allowed"},
+        {406, "Not Acceptable"},
+        {408, "Request Timeout"},
+        {409, "Conflict"},
+        {410, "Gone"},
+        {411, "Length Required"},
+        {412, "Precondition Failed"},
+        {413, "Payload Too Large"},
+        {414, "URI Too Long"},
+        {415, "Unsupported Media Type"},
+        {416, "Range Not Satisfiable"},
+        {422, "Unprocessable Entity"},
+        {426, "Upgrade Required"},
+        {429, "Too Many Requests"},
+        {431, "Request Header Fields Too Large"},
+        {500, "Internal Server Error"},
+        {501, "Not Implemented"},
+        {502, "Bad Gateway"},
+        {503, "Service Unavailable"},
+        {504, "Gateway Timeout"},
+        {505, "HTTP Version Not Supported"},
+    };
+
+    struct status_table
+    {
+      std::array<std::string, CODES_SIZE> lines;
+      std::array<const char *, CODES_SIZE> reasons;
+    };
+
+    auto statuses() -> const status_table &
+    {
+      static const auto table = []()
+      {
+        status_table t;
+        t.reasons.fill("");
+        for (const auto &s : STATUSES)
+        {
+          t.lines[s.code] = std::string(response::PROTO_DEFAULT) + " " + std::to_string(s.code) + " " + s.reason + "\r\n";
+          t.reasons[s.code] = s.reason;
+        }
+        return t;
+      }();
+      return table;
+    }
+
+    // RFC 7230 3.3.2: no Content-Length for 1xx, 204 and 304
+    auto has_content_length(const int code) -> bool
+    {
+      return code >= 200 && code != 204 && code != 304;
+    }
+
+    auto append_number(std::string &out, const std::size_t value) -> void
+    {
+      char buf[24];
+      const auto r = std::to_chars(buf, buf + sizeof(buf), value);
+      out.append(buf, r.ptr - buf);
+    }
+  } // namespace
 
   response::response(int code, const char *reason)
       : code_(code)
+      , msg_()
+      , headers_()
+      , raw_headers_()
       , reason_(reason)
       , proto_v_(PROTO_DEFAULT)
-      , headers_()
-      , msg_("")
+      , body_()
+      , file_()
+      , file_offset_(0)
+      , file_length_(0)
+      , head_only_(false)
   {
-    with_proto_ver("1.1");
   }
 
-  response::~response()
-  {
-    this->code_ = 0;
-    this->headers_.clear();
-    this->proto_v_ = PROTO_DEFAULT;
-    this->msg_.clear();
-  }
+  response::~response() = default;
 
   auto response::get_status_code() -> int
   {
@@ -45,19 +133,13 @@ namespace http
 
   auto response::with_proto_ver(const char *ver) -> void
   {
-    std::string version;
-    version.reserve(strlen(PROTO_PREFIX) + strlen(ver));
-    version.append(PROTO_PREFIX);
-    version.append(ver);
-    this->proto_v_ = version;
+    proto_v_.assign(PROTO_PREFIX);
+    proto_v_.append(ver);
   }
 
   auto response::has_header(const char *key) -> bool
   {
-    const auto found = this->get_header(key);
-    if (!found) return false;
-
-    return found->key == key;
+    return this->get_header(key) != nullptr;
   }
 
   auto response::with_header(const char *key, const char *val) -> void
@@ -71,16 +153,7 @@ namespace http
     const auto found = this->get_header(key);
     if (found)
     {
-      int it = 0;
-      for (const auto &header : headers_)
-      {
-        if (header.key != found->key)
-        {
-          continue;
-        }
-        headers_.at(it) = *found;
-        ++it;
-      }
+      found->value = val;
       return;
     }
 
@@ -89,15 +162,15 @@ namespace http
 
   auto response::get_header(const char *key) -> header *
   {
-    if (std::strlen(key) == 0) return nullptr;
-    for (const auto &item : headers_)
+    if (!key || *key == '\0') return nullptr;
+    for (auto &item : headers_)
     {
-      if (item.key != key)
+      if (strcasecmp(item.key, key) != 0)
       {
         continue;
       }
 
-      return const_cast<header *>(&item);
+      return &item;
     }
 
     return nullptr;
@@ -105,75 +178,152 @@ namespace http
 
   auto response::with_body(const stream_interface::buffer body) -> void
   {
-    stream_.write_bytes(body);
+    body_.assign(body.data(), body.size());
   }
 
   auto response::with_body(const stream_interface::buffer *body) -> void
   {
-    stream_.write_bytes(body);
+    body_.assign(body->data(), body->size());
+  }
+
+  auto response::with_body(const char *data) -> void
+  {
+    body_.assign(data);
   }
 
   auto response::get_body() -> stream_interface::buffer
   {
-    return *stream_.read();
+    // with terminating zero
+    return {body_.c_str(), body_.c_str() + body_.size() + 1};
   }
 
-  auto response::get_message() -> const char *
+  auto response::serialize(std::string &out) -> void
   {
-    std::string http = proto_v_;
-    http += " ";
-    http += std::to_string(code_) + " " + reason_;
-    http += CRLF;
+    const int code = get_status_code();
+    const auto cached = status_line(code);
+    const bool default_reason = !reason_ || *reason_ == '\0' || std::strcmp(reason_, reason_phrase(code)) == 0;
 
-    with_added_header("Content-Length", std::to_string(stream_.get_size()).c_str());
+    if (!cached.empty() && default_reason && proto_v_ == PROTO_DEFAULT)
+    {
+      out.append(cached);
+    }
+    else
+    {
+      out.append(proto_v_);
+      out.push_back(' ');
+      append_number(out, code);
+      out.push_back(' ');
+      out.append(reason_ && *reason_ ? reason_ : reason_phrase(code));
+      out.append(CRLF);
+    }
 
-    for (const auto &header : headers_)
+    for (const auto &line : raw_headers_)
     {
-      http += header.key;
-      http += ":";
-      http += header.value;
-      http += CRLF;
+      out.append(line);
     }
 
-    http += CRLF;
-    for (const auto &item : *stream_.read())
+    for (const auto &header : headers_)
     {
-      http += item;
+      // always computed from the body
+      if (strcasecmp(header.key, "Content-Length") == 0) continue;
+
+      out.append(header.key);
+      out.append(": ");
+      out.append(header.value);
+      out.append(CRLF);
     }
 
-    int i{0};
-    while (i < http.size())
+    if (has_content_length(code))
     {
-      msg_.push_back(http[i++]);
+      out.append("Content-Length: ");
+      append_number(out, file_ ? file_length_ : body_.size());
+      out.append(CRLF);
     }
 
+    out.append(CRLF);
+  }
+
+  auto response::get_message() -> const char *
+  {
+    msg_.clear();
+    serialize(msg_);
+    if (!head_only_) msg_.append(body_);
+
     return this->msg_.c_str();
   }
 
+  auto response::reset() -> void
+  {
+    code_ = 200;
+    reason_ = "OK";
+    proto_v_.assign(PROTO_DEFAULT);
+    headers_.clear();
+    raw_headers_.clear();
+    body_.clear();
+    msg_.clear();
+    file_.reset();
+    file_offset_ = 0;
+    file_length_ = 0;
+    content_range_.clear();
+    head_only_ = false;
+  }
+
+  auto response::status_line(const int code) -> std::string_view
+  {
+    if (code < 0 || code >= CODES_SIZE) return {};
+
+    return statuses().lines[code];
+  }
+
+  auto response::reason_phrase(const int code) -> const char *
+  {
+    if (code < 0 || code >= CODES_SIZE) return "";
+
+    return statuses().reasons[code];
+  }
+
   auto response::with_view(const char *p) -> void
   {
     const auto static_dir = std::filesystem::current_path().string() + "/public";
     const std::string path = static_dir + p;
-    const auto is_regular_file = std::filesystem::is_regular_file(path);
-    const auto is_file_exist = std::filesystem::exists(path);
 
-    if (!is_regular_file || !is_file_exist)
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
     {
+      ::close(fd);
       return;
     }
 
-    std::ifstream file(path, std::ios::binary);
-    std::stringstream buf;
-    buf << file.rdbuf();
-    file.close();
+    body_.resize(st.st_size);
+    std::size_t done = 0;
+    while (done < body_.size())
+    {
+      const auto r = ::read(fd, body_.data() + done, body_.size() - done);
+      if (r == -1 && errno == EINTR) continue;
+      if (r <= 0) break;
+      done += r;
+    }
+    ::close(fd);
+    body_.resize(done);
+  }
+
+  auto response::with_file(static_files::file_ptr file, const off_t offset, const std::size_t length) -> void
+  {
+    if (!file) return;
 
-    http::stream::buffer stream_buf;
-    for (const auto &c : buf.str())
+    if (offset != 0 || length != file->size)
     {
-      stream_buf.push_back(c);
+      content_range_ = "bytes " + std::to_string(offset) + "-" + std::to_string(offset + length - 1) + "/" +
+                       file->content_length;
+      with_added_header("Content-Range", content_range_.c_str());
     }
 
-    this->with_body(&stream_buf);
+    file_ = std::move(file);
+    file_offset_ = offset;
+    file_length_ = length;
   }
 
   auto response::with_redirect(const char *location, const int code, const char *phrase) -> void
@@ -184,27 +334,6 @@ namespace http
 
   auto response::with_json(const miniJson::Json *data) -> void
   {
-    const auto str = data->serialize();
-
-    std::vector<char> body{};
-    for (const auto &c : str)
-    {
-      body.push_back(c);
-    }
-    this->with_body(body);
-  }
-
-  auto response::with_body(const char *data) -> void
-  {
-    auto size = std::strlen(data);
-    std::vector<char> body{};
-
-    int i = 0;
-    while (i < size)
-    {
-      body.push_back(data[i]);
-      ++i;
-    }
-    this->with_body(body);
+    body_ = data->serialize();
   }
 } // namespace http
@@ -2,11 +2,22 @@
 
 #include <minijson/json.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "response_interface.h++"
+#include "static_files.h++"
+#include "stream.h++"
 
 namespace http
 {
+  /**
+   * Response owns its body. Head (status line and headers) is rendered into
+   * a caller buffer by serialize() and sent together with the body by one
+   * writev, so the body is never copied into the message. Reactor keeps one
+   * response per connection and reset() it between requests: headers and
+   * body keep their capacity, a steady stream of responses does not allocate.
+   */
   class response final : public response_interface
   {
   public:
@@ -21,6 +32,9 @@ namespace http
 
     auto get_status_code() -> int override;
 
+    /**
+     * Empty reason is replaced by the standard one of the code
+     */
     auto with_status(int code, const char *reason = "") -> response * override;
 
     auto get_reason_phrase() -> const char * override { return reason_; }
@@ -42,12 +56,18 @@ namespace http
 
     auto get_header(const char *key) -> header * override;
 
+    /**
+     * Copy of the body, zero terminated
+     */
     auto get_body() -> stream_interface::buffer override;
 
     auto with_body(const stream_interface::buffer body) -> void override;
     auto with_body(const stream_interface::buffer *body) -> void override;
     auto with_body(const char *data) -> void override;
 
+    /**
+     * Head and body as one string. The reactor uses serialize() instead.
+     */
     auto get_message() -> const char * override;
 
   public:
@@ -57,11 +77,75 @@ namespace http
 
     auto with_json(const miniJson::Json *data) -> void;
 
+    auto with_body(std::string_view body) -> void { body_.assign(body); }
+
+    auto get_body_view() -> std::string_view { return body_; }
+
+    /**
+     * Pre-rendered header line ("Key: Value\r\n"), written to the head as is.
+     * The line is not copied, it must outlive the response.
+     */
+    auto with_raw_header(std::string_view line) -> void { raw_headers_.push_back(line); }
+
+    /**
+     * Body is a part of the static file, it is written by the reactor after
+     * the head (from memory or with sendfile) and is not copied to message.
+     */
+    auto with_file(static_files::file_ptr file, const off_t offset, const std::size_t length) -> void;
+
+    auto get_file() -> const static_files::file_ptr & { return file_; }
+
+    auto get_file_offset() -> off_t { return file_offset_; }
+
+    auto get_file_length() -> std::size_t { return file_length_; }
+
+    /**
+     * Response to HEAD: Content-Length is still computed from the body or
+     * the file, but neither is written after the head
+     */
+    auto with_head_only(const bool head_only) -> void { head_only_ = head_only; }
+
+    auto is_head_only() -> bool { return head_only_; }
+
+    /**
+     * Append status line and headers (with Content-Length) to the buffer
+     */
+    auto serialize(std::string &out) -> void;
+
+    /**
+     * Size of the last get_message(), body may contain zero bytes
+     */
+    auto get_message_size() -> std::size_t { return msg_.size(); }
+
+    /**
+     * Back to 200 OK without headers and body, buffers keep their capacity
+     */
+    auto reset() -> void;
+
+    /**
+     * "HTTP/1.1 <code> <reason>\r\n" rendered once per known code, empty
+     * for unknown codes
+     */
+    static auto status_line(const int code) -> std::string_view;
+
+    /**
+     * Standard reason phrase (RFC 7231 6.1), empty for unknown codes
+     */
+    static auto reason_phrase(const int code) -> const char *;
+
   private:
     int code_;
     std::string msg_;
     key_value headers_;
+    std::vector<std::string_view> raw_headers_;
     const char *reason_;
     std::string proto_v_;
+    std::string body_;
+
+    static_files::file_ptr file_;
+    off_t file_offset_;
+    std::size_t file_length_;
+    std::string content_range_;
+    bool head_only_;
   };
 } // namespace http
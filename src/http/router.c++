@@ -1,11 +1,18 @@
 #include "router.h++"
 
+#include <algorithm>
 #include <cstring>
-#include <reflex/stdmatcher.h>
+#include <reflex/matcher.h>
+#include <reflex/pattern.h>
+#include <stdexcept>
 
 namespace http
 {
-  router::router() = default;
+  router::router()
+      : routes_()
+      , nodes_(1)
+  {
+  }
 
   router::~router() = default;
 
@@ -15,19 +22,19 @@ namespace http
     const auto is_method_allowed = this->is_method_allowed(found, method);
     if (is_method_allowed) return;
 
-    route *router_ = new route;
-    router_->url = url;
-    router_->methods.push_back(method);
-    router_->handler = std::move(handler);
-    this->routes_.push_back(router_);
+    check_params(url);
+    routes_.push_back({url, std::move(handler), {method}, method_bit(method), static_cast<uint32_t>(routes_.size())});
+    insert(routes_.size() - 1);
   }
 
   auto router::add(const char *url, methods_map methods, const handlers &&handler) -> void
   {
     const auto found = this->find(url);
     int matched = 0;
+    uint32_t mask = 0;
     for (const auto &m : methods)
     {
+      mask |= method_bit(m);
       const auto is_exists = is_method_allowed(found, m);
       if (is_exists)
       {
@@ -40,145 +47,267 @@ namespace http
       return;
     }
 
-    route *router_ = new route;
-    router_->url = url;
-    router_->methods = methods;
-    router_->handler = std::move(handler);
-    this->routes_.push_back(router_);
+    check_params(url);
+    routes_.push_back({url, std::move(handler), methods, mask, static_cast<uint32_t>(routes_.size())});
+    insert(routes_.size() - 1);
   }
 
   auto router::add(const char *url, methods_map methods, const handlers *handler) -> void
   {
-    const auto found = this->find(url);
-    int matched = 0;
-    for (const auto &m : methods)
+    add(url, methods, std::move(*handler));
+  }
+
+  auto router::is_method_allowed(const route *route, const req::methods method) -> bool
+  {
+    if (!route) return false;
+
+    return (route->methods_mask & method_bit(method)) != 0;
+  }
+
+  auto router::find(const char *url) -> route *
+  {
+    for (auto &route : routes_)
     {
-      const auto is_exists = is_method_allowed(found, m);
-      if (is_exists)
+      // full complaring
+      if (route.url != url)
       {
-        ++matched;
+        continue;
       }
+
+      return &route;
     }
+    return nullptr;
+  }
 
-    if (matched == methods.size())
+  auto router::get_routers() -> map
+  {
+    map routes;
+    routes.reserve(routes_.size());
+    for (auto &route : routes_)
     {
-      return;
+      routes.push_back(&route);
     }
+    return routes;
+  }
+
+  auto router::match(const char *url) -> route *
+  {
+    params_map params;
+    const route *fallback = nullptr;
+    const auto found = walk(0, url, 0, params, fallback);
+    return const_cast<route *>(found ? found : fallback);
+  }
 
-    route *router_ = new route;
-    router_->url = url;
-    router_->methods = methods;
-    router_->handler = std::move(*handler);
-    this->routes_.push_back(router_);
+  auto router::match(std::string_view url, const req::methods method, params_map &params) const -> const route *
+  {
+    params.clear();
+
+    // query string is not a part of route
+    const auto query = url.find('?');
+    if (query != std::string_view::npos) url = url.substr(0, query);
+
+    // 405 only when no candidate route allows the method, params are not captured then
+    const route *fallback = nullptr;
+    const auto found = walk(0, url, method_bit(method), params, fallback);
+    return found ? found : fallback;
   }
 
-  auto router::is_method_allowed(const route *router, const req::methods method) -> bool
+  auto router::shutdown() -> void
   {
-    for (const auto &route : routes_)
+    routes_.clear();
+    nodes_.clear();
+    nodes_.emplace_back();
+  }
+
+  // ---------------------------------------------------------------------------
+  // PRIVATE FUNCTIONS
+  // ---------------------------------------------------------------------------
+  auto router::insert(const uint32_t route_index) -> void
+  {
+    std::string_view path = routes_[route_index].url;
+    uint32_t n = 0;
+    while (!path.empty())
     {
-      if (route != router)
-      {
-        continue;
-      }
+      const auto slash = path.find('/');
+      const auto segment = path.substr(0, slash);
+      path.remove_prefix(slash == std::string_view::npos ? path.size() : slash + 1);
+      if (segment.empty()) continue;
 
-      for (const auto &m : route->methods)
-      {
-        if (m == method)
-        {
-          return true;
-        }
-      }
+      n = child(n, segment);
     }
-    return false;
+
+    nodes_[n].routes.push_back(route_index);
   }
 
-  auto router::find(const char *url) -> route *
+  auto router::child(const uint32_t parent, std::string_view segment) -> uint32_t
   {
-    for (const auto &route : routes_)
+    std::string_view pattern;
+    const auto type = classify(segment, pattern);
+
+    // nodes_ may grow, so the parent is addressed by index only
+    uint32_t found = NONE;
+    auto &statics = nodes_[parent].statics;
+    const auto it = std::lower_bound(statics.begin(), statics.end(), segment,
+        [](const auto &item, std::string_view s) { return std::string_view(item.first) < s; });
+    switch (type)
     {
-      // full complaring
-      if (std::strcmp(route->url, url) != 0)
+    case segment_type::fixed:
+      if (it != statics.end() && it->first == segment) found = it->second;
+      break;
+    case segment_type::integer: found = nodes_[parent].integer; break;
+    case segment_type::any: found = nodes_[parent].any; break;
+    case segment_type::regex:
+      for (const auto &r : nodes_[parent].regexes)
       {
-        continue;
+        if (r.pattern == pattern) found = r.node;
       }
+      break;
+    }
+    if (found != NONE) return found;
+
+    // pattern is compiled before the trie changes, a bad regex throws here
+    std::shared_ptr<const reflex::Pattern> re;
+    if (type == segment_type::regex) re = std::make_shared<const reflex::Pattern>(std::string(pattern));
 
-      return route;
+    const uint32_t created = nodes_.size();
+    const auto position = it - statics.begin();
+    nodes_.emplace_back();
+    auto &p = nodes_[parent];
+    switch (type)
+    {
+    case segment_type::fixed: p.statics.emplace(p.statics.begin() + position, std::string(segment), created); break;
+    case segment_type::integer: p.integer = created; break;
+    case segment_type::any: p.any = created; break;
+    case segment_type::regex: p.regexes.push_back({std::string(pattern), std::move(re), created}); break;
     }
-    return nullptr;
+
+    return created;
   }
 
-  auto router::match(const char *url) -> route *
+  auto router::walk(const uint32_t n, std::string_view path, const uint32_t method, params_map &params,
+      const route *&fallback) const -> const route *
   {
-    map candidates;
-    for (const auto &route : routes_)
+    while (!path.empty() && path.front() == '/')
+      path.remove_prefix(1);
+
+    const auto &current = nodes_[n];
+    if (path.empty()) return pick(current, method, fallback);
+
+    const auto slash = path.find('/');
+    const auto segment = path.substr(0, slash);
+    const auto rest = slash == std::string_view::npos ? std::string_view{} : path.substr(slash);
+
+    // static segments win over params
+    const auto it = std::lower_bound(current.statics.begin(), current.statics.end(), segment,
+        [](const auto &item, std::string_view s) { return std::string_view(item.first) < s; });
+    if (it != current.statics.end() && it->first == segment)
     {
-      // full comparing
-      if (std::strcmp(route->url, url) == 0)
-      {
-        return route;
-      }
+      const auto found = walk(it->second, rest, method, params, fallback);
+      if (found) return found;
+    }
 
-      // comparing with regex
-      {
-        const auto tokens_original = this->get_tokens(url);
-        const auto tokens_router = this->get_tokens(route->url);
-        if (tokens_original.size() != tokens_router.size()) continue;
-      }
+    if (!params.push_back(segment)) return nullptr;
 
-      reflex::StdMatcher matcher(route->url, url);
-      for (auto &match : matcher.find)
-      {
-        candidates.push_back(route);
-      }
+    if (current.integer != NONE && is_integer(segment))
+    {
+      const auto found = walk(current.integer, rest, method, params, fallback);
+      if (found) return found;
     }
 
-    if (candidates.size() == 1)
+    if (current.any != NONE)
     {
-      const auto found = candidates.at(0);
-      for (const auto &candidate : candidates)
-      {
-        const auto token_route = this->get_tokens(candidate->url);
-        const auto token_original = this->get_tokens(url);
-        int i = 0;
-        for (const auto &token : token_original)
-        {
-          if (token != token_route.at(i))
-          {
-            found->params.push_back(token);
-          }
-          ++i;
-        }
-      }
-      return found;
+      const auto found = walk(current.any, rest, method, params, fallback);
+      if (found) return found;
+    }
+
+    for (const auto &r : current.regexes)
+    {
+      if (!matches(*r.re, segment)) continue;
+
+      const auto found = walk(r.node, rest, method, params, fallback);
+      if (found) return found;
     }
 
+    params.pop_back();
     return nullptr;
   }
 
-  auto router::get_tokens(const char *path) -> tokens_map
+  auto router::pick(const node &n, const uint32_t method, const route *&fallback) const -> const route *
   {
-    tokens_map map;
-    reflex::StdMatcher matcher("[^\\/]+", path);
-    for (auto &match : matcher.find)
+    if (n.routes.empty()) return nullptr;
+
+    for (const auto index : n.routes)
     {
-      map.push_back(match.text());
+      if (routes_[index].methods_mask & method) return &routes_[index];
     }
-    return map;
+
+    // url matched, method not: siblings may still allow it
+    if (!fallback) fallback = &routes_[n.routes.front()];
+    return nullptr;
   }
 
-  auto router::reset() -> void
+  auto router::classify(std::string_view segment, std::string_view &pattern) -> segment_type
   {
-    for (const auto &router : routes_)
+    // {name}, {name:int}, {name:regex}
+    if (segment.size() > 2 && segment.front() == '{' && segment.back() == '}')
     {
-      router->params.clear();
+      const auto inner = segment.substr(1, segment.size() - 2);
+      const auto colon = inner.find(':');
+      if (colon == std::string_view::npos) return segment_type::any;
+
+      pattern = inner.substr(colon + 1);
+      if (pattern == "int") return segment_type::integer;
+      return segment_type::regex;
     }
+
+    // plain regex segment, a dot alone keeps it static (/favicon.ico)
+    if (segment.find_first_of("\\*+?[]()|^$") != std::string_view::npos)
+    {
+      pattern = segment;
+      return segment_type::regex;
+    }
+
+    return segment_type::fixed;
   }
 
-  auto router::shutdown() -> void
+  auto router::matches(const reflex::Pattern &pattern, std::string_view segment) -> bool
+  {
+    // one matcher per thread, its buffer is allocated once and reused
+    thread_local reflex::Matcher matcher;
+    matcher.pattern(pattern);
+    matcher.input(reflex::Input(segment.data(), segment.size()));
+    return matcher.matches() != 0;
+  }
+
+  auto router::is_integer(std::string_view segment) -> bool
+  {
+    if (segment.empty()) return false;
+
+    return std::all_of(segment.begin(), segment.end(), [](char c) { return c >= '0' && c <= '9'; });
+  }
+
+  auto router::count_params(std::string_view url) -> std::size_t
+  {
+    std::size_t count = 0;
+    while (!url.empty())
+    {
+      const auto slash = url.find('/');
+      const auto segment = url.substr(0, slash);
+      url.remove_prefix(slash == std::string_view::npos ? url.size() : slash + 1);
+      if (segment.empty()) continue;
+
+      std::string_view pattern;
+      if (classify(segment, pattern) != segment_type::fixed) ++count;
+    }
+    return count;
+  }
+
+  auto router::check_params(std::string_view url) -> void
   {
-    for (const auto &router : routes_)
+    // deeper params could never be captured, the route would never match
+    if (count_params(url) > params_map::CAPACITY)
     {
-      delete router;
+      throw std::invalid_argument("[Router] too many params in route: " + std::string(url));
     }
   }
 } // namespace http
@@ -1,21 +1,41 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <http/request.h++>
 #include <http/response.h++>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
+namespace reflex
+{
+  class Pattern;
+}
+
 namespace http
 {
+  /**
+   * Routes are compiled into a segment trie. A segment of the route url is:
+   *  - static:       /blog
+   *  - typed param:  /{id:int}
+   *  - any param:    /{slug}
+   *  - regex param:  /{slug:[a-z-]+} or a plain regex segment /\\d+
+   * Routes are inserted into the trie by add(), regex segments are compiled
+   * to RE/flex DFA patterns there. Regex is evaluated only for the segments
+   * where it is declared, by a matcher of the calling thread. Matching does
+   * not allocate: params are views into the matched url.
+   */
   class router
   {
   private:
     using str = std::string;
     using req = http::request;
     using res = http::response;
-    using tokens_map = std::vector<str>;
     using methods_map = std::vector<req::methods>;
-    using params_map = std::vector<str>;
+    using params_map = req::params_map;
 
   public:
     struct route;
@@ -29,7 +49,8 @@ namespace http
 
     /**
      * Add handler to container.
-     * Endpoint is unique. The same url with different methods will be make a different instances
+     * Endpoint is unique. The same url with different methods will be make a different instances.
+     * Throws std::invalid_argument when the url has more params than params_map::CAPACITY.
      */
     auto add(const char *url, req::methods method, const handlers &&handler) -> void;
     auto add(const char *url, methods_map methods, const handlers &&handler) -> void;
@@ -41,27 +62,93 @@ namespace http
 
     auto get_size() -> const int { return routes_.size(); }
 
-    auto get_routers() -> map { return this->routes_; }
+    auto get_routers() -> map;
 
+    /**
+     * Find route by url, captured params are dropped.
+     */
     auto match(const char *url) -> route *;
 
-    auto reset() -> void;
+    /**
+     * Find route by url and method. Route allowing the method is preferred,
+     * otherwise any route of the url is returned (method not allowed).
+     * Safe to call concurrently while no routes are added.
+     */
+    auto match(std::string_view url, const req::methods method, params_map &params) const -> const route *;
 
     auto shutdown() -> void;
 
-  private:
-    auto get_tokens(const char *path) -> tokens_map;
+    static auto method_bit(const req::methods method) -> uint32_t { return 1u << static_cast<uint32_t>(method); }
 
   public:
     struct route
     {
-      const char *url;
+      std::string url;
       handlers handler;
       methods_map methods;
-      params_map params;
+      uint32_t methods_mask;
+      uint32_t index; // order of add(), metrics key
     };
 
   private:
-    map routes_;
+    constexpr static uint32_t NONE = UINT32_MAX;
+
+    enum class segment_type : uint8_t
+    {
+      fixed,
+      integer,
+      any,
+      regex,
+    };
+
+    struct regex_child
+    {
+      std::string pattern;
+      std::shared_ptr<const reflex::Pattern> re; // immutable, shared by router copies
+      uint32_t node;
+    };
+
+    struct node
+    {
+      std::vector<std::pair<std::string, uint32_t>> statics; // sorted by segment, kept sorted on insert
+      uint32_t integer = NONE;
+      uint32_t any = NONE;
+      std::vector<regex_child> regexes; // declaration order
+      std::vector<uint32_t> routes;
+    };
+
+    auto insert(const uint32_t route_index) -> void;
+
+    auto child(const uint32_t parent, std::string_view segment) -> uint32_t;
+
+    /**
+     * Route of the path allowing the method. All candidate segments are
+     * tried before giving up, the first route of the path with another
+     * method is kept in fallback.
+     */
+    auto walk(const uint32_t n, std::string_view path, const uint32_t method, params_map &params,
+        const route *&fallback) const -> const route *;
+
+    auto pick(const node &n, const uint32_t method, const route *&fallback) const -> const route *;
+
+    static auto classify(std::string_view segment, std::string_view &pattern) -> segment_type;
+
+    /**
+     * Whole segment matches the pattern
+     */
+    static auto matches(const reflex::Pattern &pattern, std::string_view segment) -> bool;
+
+    static auto is_integer(std::string_view segment) -> bool;
+
+    /**
+     * Param segments of the url, a match captures one value per param
+     */
+    static auto count_params(std::string_view url) -> std::size_t;
+
+    static auto check_params(std::string_view url) -> void;
+
+  private:
+    std::deque<route> routes_;
+    std::vector<node> nodes_;
   };
 } // namespace http
@@ -1,76 +1,63 @@
 #include "server.h++"
 
 #include <csignal>
+#include <cstdio>
+#include <future>
 #include <utils/logger.h++>
+#include <utils/metrics.h++>
 
 #include "http/middlewares/response.h++"
-#include "http/parser.h++"
 
 namespace http
 {
   server *server::instance = nullptr;
 
   server::server(options_interface *options)
-      : srv_(sock::make_tcp(options->get_host(), options->get_port()))
-      , options_(options)
-      , epoll_(new io::epoll())
+      : options_(options)
       , router_()
+      , server_header_(std::string("Server: ") + options->get_name() + CRLF)
+      , thr_pool(resolve_workers(options))
       , running_(false)
   {
     this->instance = this;
 
-    srv_->open();
-    srv_->set_non_blocking();
-    srv_->reuse_addr(true);
-    srv_->reuse_port(true);
-    srv_->bind();
-    srv_->listen();
-
-    try
-    {
-      epoll_->create();
-      epoll_->set_timeout(1000);
-      epoll_->register_master(srv_->get_fd(), io::epoll::Events::READ);
-    }
-    catch (std::runtime_error &e)
+    const char *local_path = options_->get_local_path();
+    const bool local = local_path && *local_path;
+    if (local && !open_local())
     {
-      LOG_ERROR("Failed to initialize epoll: {}", e.what());
+      LOG_ERROR("Failed to listen on {}", local_path);
       shutdown();
       return;
     }
 
-    epoll_->on_connection([this](int socket) {});
-
-    epoll_->on_close([this](int socket) {});
-
-    epoll_->on_write(
-        [this](int socket, const char *buf)
-        {
-          http::parser parser{buf};
-          auto req_line = parser.get_req_line();
-          http::request req;
-          auto request = req.parse(req_line);
-          http::response res{200, "OK"};
-          res.with_added_header("Server", options_->get_name());
-          for (auto &mid : middlewares_)
-          {
-            const auto m = static_cast<http::middlewares::response *>(mid);
-            m->set_router(&router_);
-            m->execute(&req, res);
-          }
-          auto msg = res.get_message();
-          srv_->write(socket, msg, std::strlen(msg));
-          epoll_->unwatch(socket);
-          router_.reset();
-        });
+    const int workers = thr_pool.get_workers().size();
+    for (int i = 0; i < workers; ++i)
+    {
+      auto r = std::make_unique<reactor>(this, i);
+      const bool opened = local ? r->open(local_->get_fd()) : r->open(options_->get_host(), options_->get_port());
+      if (!opened)
+      {
+        LOG_ERROR("Failed to start reactor {}", i);
+        shutdown();
+        return;
+      }
+      reactors_.push_back(std::move(r));
+    }
 
+    if (local)
+    {
+      LOG_INFO("Server started {} reactor(s) on {}", workers, local_path);
+    }
+    else
+    {
+      LOG_INFO("Server started {} reactor(s) on {}:{}", workers, options_->get_host(), options_->get_port());
+    }
     running_ = true;
   }
 
   server::~server()
   {
-    if (epoll_) delete epoll_;
-    // srv_ is now a smart pointer - no manual delete needed
+    reactors_.clear();
     LOG_INFO("Server is shutting down");
   }
 
@@ -79,23 +66,71 @@ namespace http
     // Catch user CTRL+C
     std::signal(SIGINT, &server::signal_handler);
 
-    while (running_)
+    // route labels of metrics, shards of reactor threads are sized by them
+    std::vector<std::string> routes(router_.get_size());
+    for (const auto route : router_.get_routers())
     {
-      try
-      {
-        epoll_->wait();
-      }
-      catch (std::runtime_error &e)
-      {
-        LOG_ERROR("Exception during epoll wait: {}", e.what());
-      }
+      routes[route->index] = route->url;
+    }
+    utils::metrics::registry::get().set_routes(std::move(routes));
+
+    // router is shared by all reactors, it must be set before loops start
+    for (auto &mid : middlewares_)
+    {
+      const auto m = static_cast<http::middlewares::response *>(mid);
+      m->set_router(&router_);
+    }
+
+    const bool pin = reactors_.size() > 1;
+    std::vector<std::future<void>> loops;
+    for (auto &r : reactors_)
+    {
+      loops.push_back(thr_pool.enqueue([&r, pin]() { r->run(pin); }));
+    }
+
+    for (auto &loop : loops)
+    {
+      loop.wait();
     }
 
     return 0;
   }
 
+  auto server::handle(const request_parser &parser, response &res) -> void
+  {
+    http::request req;
+    req.parse(parser);
+    res.with_raw_header(server_header_);
+    for (auto &mid : middlewares_)
+    {
+      mid->execute(&req, res);
+    }
+  }
+
   auto server::shutdown() -> void
   {
     running_ = false;
   }
+
+  auto server::open_local() -> bool
+  {
+    const char *path = options_->get_local_path();
+    // socket file of a previous run
+    std::remove(path);
+
+    local_ = std::make_unique<io::local_socket>(path, SOCK_STREAM);
+    if (!local_->open()) return false;
+
+    local_->set_non_blocking();
+    return local_->bind() && local_->listen();
+  }
+
+  auto server::resolve_workers(options_interface *options) -> int
+  {
+    const int workers = options->get_workers();
+    if (workers > 0) return workers;
+
+    const int cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+  }
 } // namespace http
@@ -1,13 +1,16 @@
 #pragma once
 
-#include <io/epoll/epoll.h++>
 #include <io/sockets/inet_socket.h++>
+#include <io/sockets/local_socket.h++>
+#include <memory>
 #include <utils/thread_pool.h++>
 #include <vector>
 
 #include "middleware_interface.h++"
 #include "options_interface.h++"
+#include "reactor.h++"
 #include "request.h++"
+#include "request_parser.h++"
 #include "response.h++"
 #include "router.h++"
 
@@ -27,26 +30,54 @@ namespace http
 
     ~server();
 
+    /**
+     * Run all reactors on the thread pool and block until shutdown.
+     */
     auto listen() -> int;
 
     auto add_middleware(const middleware *mdw) -> void { middlewares_.push_back(const_cast<middleware *>(mdw)); }
 
     auto shutdown() -> void;
 
+    /**
+     * Routes are copied with their compiled trie, the router is read-only afterwards
+     */
     auto with_routers(const router *r) -> void { this->router_ = *r; }
 
     auto is_running() -> bool { return this->running_; };
 
+    auto get_workers() -> int { return reactors_.size(); }
+
+    auto get_options() -> options_interface * { return options_; }
+
+    /**
+     * "Server: <name>\r\n", rendered once
+     */
+    auto get_server_header() -> std::string_view { return server_header_; }
+
+    /**
+     * Run request through middlewares. Called from reactor threads concurrently.
+     */
+    auto handle(const request_parser &parser, response &res) -> void;
+
   private:
     auto static signal_handler(int s) -> void { instance->running_ = false; }
 
+    auto static resolve_workers(options_interface *options) -> int;
+
+    /**
+     * Listen socket on options local path, shared by the reactors
+     */
+    auto open_local() -> bool;
+
   private:
     static server *instance;
     options_interface *options_;
     router router_;
+    std::string server_header_;
 
-    io::epoll *epoll_;
-    std::unique_ptr<io::inet_socket> srv_;
+    std::unique_ptr<io::local_socket> local_;
+    std::vector<std::unique_ptr<reactor>> reactors_;
 
     utils::thread_pool thr_pool;
     std::atomic<bool> running_ = false;
@@ -0,0 +1,504 @@
+#include "static_files.h++"
+
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/logger.h++>
+
+#include "mime.h++"
+
+namespace http
+{
+  namespace
+  {
+    constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                    IN_DELETE_SELF | IN_MOVE_SELF;
+
+    // "/a/../b" must not leave the public dir
+    auto is_safe(std::string_view path) -> bool
+    {
+      if (path.empty() || path.front() != '/') return false;
+      if (path.find('\0') != std::string_view::npos) return false;
+
+      std::size_t pos = 0;
+      while (pos < path.size())
+      {
+        const auto next = path.find('/', pos + 1);
+        const auto segment = path.substr(pos + 1, next == std::string_view::npos ? next : next - pos - 1);
+        if (segment == "..") return false;
+        if (next == std::string_view::npos) break;
+        pos = next;
+      }
+      return true;
+    }
+
+    // one spelling per file: "//a" or "/./a" would not be invalidated with "/a"
+    auto is_canonical(std::string_view path) -> bool
+    {
+      return path.find("//") == std::string_view::npos && path.find("/./") == std::string_view::npos &&
+             !path.ends_with("/.");
+    }
+
+    auto parse_number(std::string_view s, std::size_t &value) -> bool
+    {
+      if (s.empty()) return false;
+      const auto r = std::from_chars(s.data(), s.data() + s.size(), value);
+      return r.ec == std::errc() && r.ptr == s.data() + s.size();
+    }
+
+    // size and nanosecond mtime, changes on every write
+    auto make_etag(const struct stat &st) -> std::string
+    {
+      char etag[64];
+      const int size = std::snprintf(etag, sizeof(etag), "\"%lx-%lx\"", static_cast<unsigned long>(st.st_size),
+          static_cast<unsigned long>(st.st_mtim.tv_sec * 1000000000L + st.st_mtim.tv_nsec));
+      return {etag, static_cast<std::size_t>(size)};
+    }
+
+    // entity-tag list of If-None-Match, weak comparison (RFC 7232 2.3.2)
+    auto etag_matches(std::string_view list, std::string_view etag) -> bool
+    {
+      while (!list.empty())
+      {
+        const auto comma = list.find(',');
+        auto tag = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+
+        while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t'))
+          tag.remove_prefix(1);
+        while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+          tag.remove_suffix(1);
+        if (tag == "*") return true;
+        if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+        if (tag == etag) return true;
+      }
+      return false;
+    }
+  } // namespace
+
+  static_file::~static_file()
+  {
+    if (fd >= 0) ::close(fd);
+  }
+
+  static_files::static_files(std::string root, const std::size_t capacity)
+      : root_(std::move(root))
+      , capacity_(capacity)
+      , enabled_(false)
+      , mutex_()
+      , entries_()
+      , lru_()
+      , epoch_(0)
+      , bytes_(0)
+      , inotify_(-1)
+      , stop_(-1)
+      , watches_()
+      , dirs_()
+      , watcher_()
+  {
+    while (!root_.empty() && root_.back() == '/')
+      root_.pop_back();
+
+    if (capacity_ == 0) return;
+
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ != -1) stop_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_ == -1 || stop_ == -1)
+    {
+      // stale files can not be detected, serve without cache
+      LOG_WARN("Failed to init inotify, static files cache is disabled: {}", std::strerror(errno));
+      capacity_ = 0;
+      return;
+    }
+
+    enabled_ = true;
+    watcher_ = std::thread([this]() { run_watcher(); });
+  }
+
+  static_files::~static_files()
+  {
+    if (watcher_.joinable())
+    {
+      eventfd_write(stop_, 1);
+      watcher_.join();
+    }
+    clear();
+    if (inotify_ >= 0) ::close(inotify_);
+    if (stop_ >= 0) ::close(stop_);
+  }
+
+  auto static_files::find(std::string_view uri) -> file_ptr
+  {
+    const auto query = uri.find_first_of("?#");
+    if (query != std::string_view::npos) uri = uri.substr(0, query);
+    if (!is_safe(uri)) return nullptr;
+
+    if (enabled_.load(std::memory_order_relaxed))
+    {
+      std::shared_lock lock(mutex_);
+      const auto found = entries_.find(uri);
+      if (found != entries_.end())
+      {
+        // the shared line is written once per insert, not on every hit
+        auto &used = found->second.used;
+        const auto epoch = epoch_.load(std::memory_order_relaxed);
+        if (used.load(std::memory_order_relaxed) != epoch) used.store(epoch, std::memory_order_relaxed);
+        return found->second.file;
+      }
+    }
+
+    char path[PATH_MAX];
+    if (root_.size() + uri.size() >= sizeof(path)) return nullptr;
+    std::memcpy(path, root_.data(), root_.size());
+    std::memcpy(path + root_.size(), uri.data(), uri.size());
+    path[root_.size() + uri.size()] = '\0';
+
+    const auto file = load(path);
+    if (!file || !enabled_.load(std::memory_order_relaxed) || !is_canonical(uri)) return file;
+
+    return insert(uri, path, file);
+  }
+
+  auto static_files::clear() -> void
+  {
+    std::unique_lock lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+    bytes_ = 0;
+  }
+
+  auto static_files::get_size() -> std::size_t
+  {
+    std::shared_lock lock(mutex_);
+    return entries_.size();
+  }
+
+  auto static_files::get_bytes() -> std::size_t
+  {
+    std::shared_lock lock(mutex_);
+    return bytes_;
+  }
+
+  auto static_files::is_not_modified(const static_file &file, std::string_view if_none_match,
+      std::string_view if_modified_since) -> bool
+  {
+    if (!if_none_match.empty()) return etag_matches(if_none_match, file.etag);
+    if (if_modified_since.empty()) return false;
+
+    const auto since = parse_date(if_modified_since);
+    return since != -1 && file.mtime <= since;
+  }
+
+  auto static_files::parse_range(const static_file &file, std::string_view range, std::string_view if_range,
+      off_t &offset, std::size_t &length) -> range_result
+  {
+    offset = 0;
+    length = file.size;
+
+    constexpr std::string_view unit = "bytes=";
+    if (range.substr(0, unit.size()) != unit) return range_result::none;
+    range.remove_prefix(unit.size());
+    if (range.find(',') != std::string_view::npos) return range_result::none;
+
+    // If-Range is an entity-tag or a date (RFC 7233 3.2)
+    if (!if_range.empty() && if_range != file.etag && if_range != file.last_modified) return range_result::none;
+
+    const auto dash = range.find('-');
+    if (dash == std::string_view::npos) return range_result::none;
+
+    const auto first_raw = range.substr(0, dash);
+    const auto last_raw = range.substr(dash + 1);
+    std::size_t first = 0;
+    std::size_t last = 0;
+
+    if (first_raw.empty())
+    {
+      // suffix range: last N bytes
+      if (!parse_number(last_raw, last)) return range_result::none;
+      if (last == 0 || file.size == 0) return range_result::unsatisfiable;
+      if (last > file.size) last = file.size;
+      offset = file.size - last;
+      length = last;
+      return range_result::partial;
+    }
+
+    if (!parse_number(first_raw, first)) return range_result::none;
+    if (last_raw.empty())
+    {
+      last = file.size == 0 ? 0 : file.size - 1;
+    }
+    else
+    {
+      if (!parse_number(last_raw, last)) return range_result::none;
+      if (last < first) return range_result::none;
+      if (last >= file.size) last = file.size == 0 ? 0 : file.size - 1;
+    }
+
+    if (first >= file.size) return range_result::unsatisfiable;
+
+    offset = first;
+    length = last - first + 1;
+    return range_result::partial;
+  }
+
+  auto static_files::format_date(const std::time_t time) -> std::string
+  {
+    std::tm tm{};
+    gmtime_r(&time, &tm);
+
+    char buf[32];
+    const auto size = std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return {buf, size};
+  }
+
+  auto static_files::parse_date(std::string_view date) -> std::time_t
+  {
+    const std::string raw(date);
+    std::tm tm{};
+    const char *end = strptime(raw.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (!end || *end != '\0') return -1;
+
+    return timegm(&tm);
+  }
+
+  // ---------------------------------------------------------------------------
+  // PRIVATE FUNCTIONS
+  // ---------------------------------------------------------------------------
+  auto static_files::load(const char *path) -> std::shared_ptr<static_file>
+  {
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return nullptr;
+
+    auto file = std::make_shared<static_file>();
+    file->fd = fd;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) return nullptr;
+
+    file->path = path;
+    file->size = st.st_size;
+    file->mtime = st.st_mtim.tv_sec;
+
+    const auto slash = file->path.rfind('/');
+    const auto dot = file->path.rfind('.');
+    const std::string ext = dot != std::string::npos && (slash == std::string::npos || dot > slash)
+                                ? file->path.substr(dot + 1)
+                                : std::string();
+    file->content_type = http::mime::content_type(ext);
+    file->content_length = std::to_string(file->size);
+    file->last_modified = format_date(file->mtime);
+
+    file->etag = make_etag(st);
+    file->range_unsatisfied = "bytes */" + file->content_length;
+
+    if (file->size > INLINE_LIMIT || file->size > capacity_) return file;
+
+    file->data.resize(file->size);
+    std::size_t done = 0;
+    while (done < file->size)
+    {
+      const auto r = ::pread(fd, file->data.data() + done, file->size - done, done);
+      if (r == -1 && errno == EINTR) continue;
+      if (r <= 0) break;
+      done += r;
+    }
+
+    // file was truncated while reading, next lookup will see the new size
+    if (done != file->size) file->data.clear();
+
+    return file;
+  }
+
+  auto static_files::insert(std::string_view key, const char *path, file_ptr file) -> file_ptr
+  {
+    std::unique_lock lock(mutex_);
+    if (!enabled_.load(std::memory_order_relaxed) || !watch(path)) return file;
+
+    // another reactor loaded it meanwhile
+    const auto found = entries_.find(key);
+    if (found != entries_.end()) return found->second.file;
+
+    // file changed before the watch was added, serve it but do not cache
+    struct stat st;
+    if (::stat(path, &st) == -1 || make_etag(st) != file->etag) return file;
+
+    const auto epoch = epoch_.load(std::memory_order_relaxed) + 1;
+    epoch_.store(epoch, std::memory_order_relaxed);
+    bytes_ += file->data.size();
+    const auto inserted = entries_.try_emplace(std::string(key), file, epoch).first;
+    // element addresses survive rehashing, iterators do not
+    inserted->second.lru = lru_.insert(lru_.end(), &inserted->first);
+    evict();
+
+    return file;
+  }
+
+  auto static_files::watch(std::string_view path) -> bool
+  {
+    // directory of the file and its parents up to the root: a renamed parent
+    // is reported by its own parent only
+    const auto slash = path.rfind('/');
+    if (slash == std::string_view::npos || slash < root_.size()) return false;
+
+    for (auto end = root_.size(); end != std::string_view::npos && end <= slash; end = path.find('/', end + 1))
+    {
+      const auto dir = path.substr(0, end);
+      if (dirs_.find(dir) != dirs_.end()) continue;
+
+      std::string watched(dir);
+      const int wd = inotify_add_watch(inotify_, watched.c_str(), WATCH_MASK);
+      if (wd == -1) return false;
+
+      // the same directory by another path (a link) keeps one descriptor
+      const auto old = watches_.find(wd);
+      if (old != watches_.end()) dirs_.erase(old->second);
+      dirs_[watched] = wd;
+      watches_[wd] = std::move(watched);
+    }
+    return true;
+  }
+
+  auto static_files::run_watcher() -> void
+  {
+    alignas(inotify_event) char buf[4096];
+    pollfd fds[2] = {{inotify_, POLLIN, 0}, {stop_, POLLIN, 0}};
+    while (true)
+    {
+      if (::poll(fds, 2, -1) == -1)
+      {
+        if (errno == EINTR) continue;
+        LOG_ERROR("Static files watcher failed, cache is dropped: {}", std::strerror(errno));
+        std::unique_lock lock(mutex_);
+        enabled_ = false;
+        entries_.clear();
+        lru_.clear();
+        bytes_ = 0;
+        return;
+      }
+      if (fds[1].revents) return;
+
+      while (true)
+      {
+        const auto size = ::read(inotify_, buf, sizeof(buf));
+        if (size <= 0) break;
+
+        std::unique_lock lock(mutex_);
+        apply_events(buf, size);
+      }
+    }
+  }
+
+  auto static_files::apply_events(const char *buf, const std::size_t size) -> void
+  {
+    for (const char *p = buf; p < buf + size;)
+    {
+      const auto event = reinterpret_cast<const inotify_event *>(p);
+      p += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW)
+      {
+        // events are lost, nothing can be trusted
+        entries_.clear();
+        lru_.clear();
+        bytes_ = 0;
+        continue;
+      }
+
+      // watch of a forgotten subtree
+      const auto dir = watches_.find(event->wd);
+      if (dir == watches_.end()) continue;
+
+      if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+      {
+        forget(std::string(dir->second));
+        continue;
+      }
+
+      if (event->len == 0) continue;
+
+      // watched directories are inside the root, the key is the rest
+      std::string path = dir->second;
+      path.push_back('/');
+      path.append(event->name);
+      if (event->mask & IN_ISDIR)
+      {
+        forget(path);
+        continue;
+      }
+      erase(std::string_view(path).substr(root_.size()));
+    }
+  }
+
+  auto static_files::forget(std::string_view dir) -> void
+  {
+    const auto inside = [&dir](std::string_view path)
+    { return path.starts_with(dir) && (path.size() == dir.size() || path[dir.size()] == '/'); };
+
+    for (auto it = watches_.begin(); it != watches_.end();)
+    {
+      if (!inside(it->second))
+      {
+        ++it;
+        continue;
+      }
+      // IN_IGNORED of the removed watch finds no directory
+      inotify_rm_watch(inotify_, it->first);
+      dirs_.erase(it->second);
+      it = watches_.erase(it);
+    }
+
+    const auto prefix = dir.substr(std::min(root_.size(), dir.size()));
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+      if (!it->first.starts_with(prefix) || it->first.size() == prefix.size() || it->first[prefix.size()] != '/')
+      {
+        ++it;
+        continue;
+      }
+      bytes_ -= it->second.file->data.size();
+      lru_.erase(it->second.lru);
+      it = entries_.erase(it);
+    }
+  }
+
+  auto static_files::erase(std::string_view key) -> void
+  {
+    const auto found = entries_.find(key);
+    if (found == entries_.end()) return;
+
+    bytes_ -= found->second.file->data.size();
+    lru_.erase(found->second.lru);
+    entries_.erase(found);
+  }
+
+  auto static_files::evict() -> void
+  {
+    const auto epoch = epoch_.load(std::memory_order_relaxed);
+    while (!lru_.empty() && (bytes_ > capacity_ || entries_.size() > ENTRIES_LIMIT))
+    {
+      const auto oldest = entries_.find(*lru_.front());
+      auto &e = oldest->second;
+
+      // hit since it was queued: second chance at the tail, once per call
+      // as the stamp is not newer than the current epoch
+      if (e.used.load(std::memory_order_relaxed) > e.queued)
+      {
+        e.queued = epoch;
+        lru_.splice(lru_.end(), lru_, lru_.begin());
+        continue;
+      }
+
+      bytes_ -= e.file->data.size();
+      lru_.pop_front();
+      entries_.erase(oldest);
+    }
+  }
+} // namespace http
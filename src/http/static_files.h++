@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+
+namespace http
+{
+  /**
+   * @brief      File of the public directory.
+   *
+   * @details    Headers are rendered once when the file is loaded. Small files
+   *             keep their bytes in memory, large ones are sent from fd with
+   *             sendfile(2). The fd stays open while the entry is referenced,
+   *             so a response in flight survives cache invalidation.
+   */
+  struct static_file
+  {
+    std::string path;
+    int fd = -1;
+    std::size_t size = 0;
+    std::time_t mtime = 0;
+    std::string data; // empty for files served with sendfile
+
+    const char *content_type = "";
+    std::string content_length;
+    std::string etag;
+    std::string last_modified;
+    std::string range_unsatisfied; // Content-Range of 416
+
+    static_file() = default;
+    static_file(const static_file &) = delete;
+    auto operator=(const static_file &) -> static_file & = delete;
+    ~static_file();
+
+    auto is_in_memory() const -> bool { return size == data.size(); }
+  };
+
+  /**
+   * @brief      Public directory lookup with LRU cache.
+   *
+   * @details    Cache is shared by all reactors and keyed by the request
+   *             path, a hit takes a shared lock only and does not allocate.
+   *             Entries are dropped when the file changes: the directory of
+   *             every cached file and its parents up to the root are watched
+   *             with inotify, a watcher thread applies the events. A renamed
+   *             or removed directory drops its subtree. Eviction is second
+   *             chance LRU: a hit stamps the entry with the insert epoch (hits
+   *             do not touch the list under the shared lock), the list head
+   *             hit since it was queued moves to the tail, else it goes.
+   */
+  class static_files
+  {
+  public:
+    using file_ptr = std::shared_ptr<const static_file>;
+
+    // files up to this size are kept in memory, bigger are sent with sendfile
+    constexpr static std::size_t INLINE_LIMIT = 1024 * 128;
+    // open file descriptors held by the cache
+    constexpr static std::size_t ENTRIES_LIMIT = 1024;
+    constexpr static std::size_t CACHE_SIZE_DEFAULT = 1024 * 1024 * 32;
+
+    enum class range_result : uint8_t
+    {
+      none = 0,          ///< No (usable) Range header, send whole file
+      partial = 1,       ///< Single satisfiable range
+      unsatisfiable = 2, ///< 416
+    };
+
+  public:
+    /**
+     * @param[in]  root      Public directory
+     * @param[in]  capacity  Memory limit of cached file bytes. Zero disables
+     *                       caching, every lookup opens the file.
+     */
+    static_files(std::string root, const std::size_t capacity = CACHE_SIZE_DEFAULT);
+
+    ~static_files();
+
+    static_files(const static_files &) = delete;
+    auto operator=(const static_files &) -> static_files & = delete;
+
+    /**
+     * @brief      Find regular file by request uri (query is ignored)
+     *
+     * @return     nullptr if there is no such file or uri leaves the root
+     */
+    auto find(std::string_view uri) -> file_ptr;
+
+    /**
+     * @brief      Drop all cached entries
+     */
+    auto clear() -> void;
+
+    auto get_size() -> std::size_t;
+
+    auto get_bytes() -> std::size_t;
+
+    /**
+     * @brief      Conditional GET (RFC 7232 6): If-None-Match wins over
+     *             If-Modified-Since
+     *
+     * @return     true when 304 must be sent
+     */
+    static auto is_not_modified(const static_file &file, std::string_view if_none_match,
+        std::string_view if_modified_since) -> bool;
+
+    /**
+     * @brief      Parse single byte range (RFC 7233 2.1). Multiple ranges and
+     *             a failed If-Range validator fall back to the whole file.
+     *
+     * @param[out] offset  First byte
+     * @param[out] length  Bytes count
+     */
+    static auto parse_range(const static_file &file, std::string_view range, std::string_view if_range, off_t &offset,
+        std::size_t &length) -> range_result;
+
+    /**
+     * @brief      IMF-fixdate (RFC 7231 7.1.1.1)
+     */
+    static auto format_date(const std::time_t time) -> std::string;
+
+    /**
+     * @return     -1 if the date is malformed
+     */
+    static auto parse_date(std::string_view date) -> std::time_t;
+
+  private:
+    using lru_list = std::list<const std::string *>; // keys, least recently queued first
+
+    struct entry
+    {
+      entry(file_ptr f, const uint64_t epoch)
+          : file(std::move(f))
+          , used(epoch)
+          , queued(epoch)
+      {
+      }
+
+      file_ptr file;
+      std::atomic<uint64_t> used; // insert epoch of the last hit
+      uint64_t queued;            // insert epoch when moved to the list tail
+      lru_list::iterator lru;
+    };
+
+    struct key_hash
+    {
+      using is_transparent = void;
+
+      auto operator()(std::string_view key) const -> std::size_t { return std::hash<std::string_view>{}(key); }
+    };
+
+    auto load(const char *path) -> std::shared_ptr<static_file>;
+
+    /**
+     * @param[in]  key   Request path
+     * @param[in]  path  File path (root and key)
+     */
+    auto insert(std::string_view key, const char *path, file_ptr file) -> file_ptr;
+
+    /**
+     * @brief      Watch directory of the file
+     *
+     * @return     false if changes of the file can not be tracked
+     */
+    auto watch(std::string_view path) -> bool;
+
+    /**
+     * @brief      Watcher thread: apply inotify events until stop_ is signaled
+     */
+    auto run_watcher() -> void;
+
+    auto apply_events(const char *buf, const std::size_t size) -> void;
+
+    /**
+     * @brief      Directory is renamed or removed: drop entries and watches
+     *             of its subtree, they are added again by the next insert
+     */
+    auto forget(std::string_view dir) -> void;
+
+    auto erase(std::string_view key) -> void;
+
+    /**
+     * @brief      Drop least recently used entries until the limits are met,
+     *             amortized O(1) per insert
+     */
+    auto evict() -> void;
+
+  private:
+    std::string root_;
+    std::size_t capacity_;
+    std::atomic<bool> enabled_; // cache is used, off when changes can not be tracked
+
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, entry, key_hash, std::equal_to<>> entries_;
+    lru_list lru_;
+    std::atomic<uint64_t> epoch_; // bumped by every insert
+    std::size_t bytes_;
+
+    int inotify_;
+    int stop_; // eventfd, wakes the watcher on destruction
+    std::unordered_map<int, std::string> watches_;                          // wd -> directory
+    std::unordered_map<std::string, int, key_hash, std::equal_to<>> dirs_; // directory -> wd
+    std::thread watcher_;
+  };
+} // namespace http
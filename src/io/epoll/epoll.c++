@@ -1,10 +1,13 @@
 #include "epoll.h++"
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
 #include <stdexcept>
 #include <unistd.h>
+#include <utils/metrics.h++>
 
 namespace io
 {
@@ -30,6 +33,7 @@ namespace io
   {
     if (masterSocket == -1) throw std::runtime_error("[Epoll] master socket not defined.");
     int num = epoll_wait(fd, events_, maxEvents, timeout);
+    if (num == -1 && errno == EINTR) return;
     if (num == -1) throw std::runtime_error("[Server] epoll wait error");
 
     for (int i = 0; i < num; ++i)
@@ -51,12 +55,24 @@ namespace io
 
       if (sock != masterSocket)
       {
-        if (events & EPOLLET | Events::WRITE)
+        bool is_open = true;
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR) && !paused_.contains(sock))
         {
-          peer_read(sock);
+          is_open = peer_read(sock);
         }
 
-        if (events == Events::CLOSE)
+        // socket was closed by a callback
+        if (!watched_.contains(sock)) continue;
+
+        if (is_open && (events & EPOLLOUT) && on_writable_)
+        {
+          on_writable_(sock);
+          if (!watched_.contains(sock)) continue;
+        }
+
+        // half-closed peer is kept by on_eof until the output is written
+        const bool is_hup = events & (EPOLLHUP | EPOLLERR) || (events & EPOLLRDHUP && !on_eof_);
+        if (!is_open || is_hup)
         {
           try
           {
@@ -107,9 +123,20 @@ namespace io
     if (remove(socket) == -1) throw std::runtime_error("[Epoll] unregister socket");
 
     watched_.erase(socket);
+    paused_.erase(socket);
     close(socket);
   }
 
+  auto epoll::resume_read(const int socket) -> void
+  {
+    if (!paused_.erase(socket)) return;
+
+    // bytes came in while paused, the edge is raised again by the modification
+    evlist.events = peer_events();
+    evlist.data.fd = socket;
+    epoll_ctl(fd, EPOLL_CTL_MOD, socket, &evlist);
+  }
+
   auto epoll::unwatch_all() -> void
   {
     for (const auto &client : watched_)
@@ -127,34 +154,62 @@ namespace io
 
   auto epoll::peer_accept() -> int
   {
+    METRICS_TIME(accept);
     struct sockaddr_in addr_;
     socklen_t peer_len = sizeof(addr_);
     int peer = accept(masterSocket, (struct sockaddr *)&addr_, &peer_len);
+    if (peer == -1) return -1;
     fcntl(peer, F_SETFL, fcntl(peer, F_GETFL, 0) | O_NONBLOCK);
 
-    watch(peer);
+    watch(peer, peer_events());
     if (on_connection_) on_connection_(peer);
 
     return peer;
   }
 
-  auto epoll::peer_read(const int peer, const int bufSize) -> const char *
+  auto epoll::peer_read(const int peer, const int bufSize) -> bool
   {
+    const auto deliver = [this, peer]()
+    {
+      if (readBuf.empty()) return;
+      if (on_data_) on_data_(peer, readBuf.data(), readBuf.size());
+      if (on_write_) on_write_(peer, readBuf.c_str());
+    };
+
     readBuf.clear();
-    char buf[bufSize];
-    memset(buf, 0, sizeof(buf));
-    int byte_count = 0;
-    while ((byte_count = ::read(peer, buf, bufSize) > 0))
+    bool is_open = true;
+    bool is_eof = false;
+    while (true)
     {
-      readBuf.append(buf);
-    }
+      // read straight into the tail of buffer
+      const auto size = readBuf.size();
+      readBuf.resize(size + bufSize);
+      const auto byte_count = METRICS_TIMED(read, ::read(peer, readBuf.data() + size, bufSize));
+      readBuf.resize(size + std::max<ssize_t>(byte_count, 0));
+
+      if (byte_count > 0)
+      {
+        if (readBuf.size() < READ_BATCH_LIMIT) continue;
+
+        deliver();
+        readBuf.clear();
+        if (!watched_.contains(peer)) return false;
+        if (paused_.contains(peer)) return true;
+        continue;
+      }
 
-    if (readBuf.empty()) return "";
+      if (byte_count == -1 && errno == EINTR) continue;
+      if (byte_count == 0) is_eof = true;
+      else if (errno != EAGAIN && errno != EWOULDBLOCK) is_open = false;
+      break;
+    }
 
-    const auto b = readBuf.c_str();
-    if (on_write_) on_write_(peer, b);
+    deliver();
 
-    return b;
+    if (!is_eof) return is_open;
+    if (!on_eof_) return false;
+    if (watched_.contains(peer)) on_eof_(peer);
+    return true;
   }
 
   auto epoll::add(const int socket, const uint32_t e) -> int
@@ -168,4 +223,9 @@ namespace io
   {
     return epoll_ctl(fd, EPOLL_CTL_DEL, socket, &evlist);
   }
+
+  auto epoll::peer_events() -> uint32_t
+  {
+    return on_writable_ ? EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP : EPOLLIN | EPOLLET | EPOLLRDHUP;
+  }
 } // namespace io
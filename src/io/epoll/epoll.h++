@@ -5,13 +5,18 @@
 #include <sys/epoll.h>
 #include <unordered_set>
 
+#include "../event_loop.h++"
+
 namespace io
 {
   /**
    * @brief      IO monitoring mechanism. Linux only.
+   * @details    When on_writable is set, peers are watched for EPOLLOUT too
+   *             (edge triggered: fires after a write hit EAGAIN and the
+   *             buffer drained), so want_writable() has nothing to do.
    * @see        man epoll
    */
-  class epoll
+  class epoll final : public event_loop
   {
   public:
     /**
@@ -32,13 +37,15 @@ namespace io
 
     ~epoll();
 
+    auto get_backend() -> backend override { return backend::epoll; }
+
     /**
      * @brief      Create epoll instance
      *
      * @return     void
      * @throws     std::runtime_error  Error create
      */
-    auto create() -> void;
+    auto create() -> void override;
 
     /**
      * @brief      Wait IO on epoll descriptor instance
@@ -47,14 +54,14 @@ namespace io
      * @return     void
      * @throws     std::runtime_error  Wait error or master socket not defined
      */
-    auto wait() -> void;
+    auto wait() -> void override;
 
     /**
      * @brief      Close epoll and connected sockets
      *
      * @return     void
      */
-    auto shutdown() -> void;
+    auto shutdown() -> void override;
 
     /**
      * @brief      Add socket to monitoring by epoll. Master socket is protected
@@ -74,7 +81,9 @@ namespace io
      *
      * @return     void
      */
-    auto register_master(const int socket, const uint32_t e = EPOLLIN) -> void;
+    auto register_master(const int socket, const uint32_t e) -> void;
+
+    auto register_master(const int socket) -> void override { register_master(socket, EPOLLIN); }
 
     /**
      * @brief      Remove socket from epoll monitoring and closing it. Master
@@ -84,7 +93,14 @@ namespace io
      *
      * @return     void
      */
-    auto unwatch(const int socket) -> void;
+    auto unwatch(const int socket) -> void override;
+
+    auto pause_read(const int socket) -> void override { paused_.insert(socket); }
+
+    /**
+     * @brief      Re-arm the peer, readiness is reported again by the next wait
+     */
+    auto resume_read(const int socket) -> void override;
 
     /**
      * @brief      Like an unwatch method, but for all clients
@@ -119,15 +135,6 @@ namespace io
      */
     auto on_incoming(std::function<void(int, bool)> &&callback) -> void { on_incoming_ = callback; };
 
-    /**
-     * @brief      A new client connection event
-     *
-     * @param      callback  The callback
-     *
-     * @return     void
-     */
-    auto on_connection(std::function<void(int)> &&callback) -> void { on_connection_ = callback; };
-
     /**
      * @brief      Write event on a socket (client sending data)
      *
@@ -138,16 +145,6 @@ namespace io
      */
     auto on_write(std::function<void(int, const char *)> &&callback) -> void { on_write_ = callback; }
 
-    /**
-     * @brief      Socket closed (client is closed connection)
-     *
-     * @param      callback  The callback
-     * @param      int   socket
-     *
-     * @return     void
-     */
-    auto on_close(std::function<void(int)> &&callback) -> void { on_close_ = callback; };
-
     /**
      * @brief      Specifies time in ms that epoll_wait() will be blocked
      *
@@ -155,7 +152,7 @@ namespace io
      *
      * @return     void
      */
-    auto set_timeout(const int ms) -> void { timeout = ms; };
+    auto set_timeout(const int ms) -> void override { timeout = ms; };
 
   private:
     /**
@@ -166,22 +163,26 @@ namespace io
     auto peer_accept() -> int;
 
     /**
-     * @brief      Peer sending data, reading it
+     * @brief      Peer sending data, reading it until EAGAIN
      *
      * @param[in]  peer     Socket fd
      * @param[in]  bufSize  Size of chunks
      *
-     * @return     readed data
+     * @return     false if read failed or peer closed connection and on_eof
+     *             is not set
      */
-    auto peer_read(const int peer, const int bufSize = 1024) -> const char *;
+    auto peer_read(const int peer, const int bufSize = 16384) -> bool;
 
     auto add(const int socket, const uint32_t e) -> int;
 
     auto remove(const int socket) -> int;
 
+    auto peer_events() -> uint32_t;
+
   private:
     constexpr static const unsigned int MAX_EVENTS_DEFAULT = 0x3e8; // 1000
     constexpr static const int WAIT_TIMEOUT_DEFAULT = 0x3e8; // 1
+    constexpr static const std::size_t READ_BATCH_LIMIT = 1024 * 64; // deliver data at least every 64Kb
 
     int fd; // epoll file descriptor
     struct epoll_event evlist, events_[MAX_EVENTS_DEFAULT];
@@ -191,10 +192,9 @@ namespace io
     std::string readBuf; // send data buffer
 
     std::function<void(int, bool)> on_incoming_;
-    std::function<void(int)> on_connection_;
     std::function<void(int, const char *)> on_write_;
-    std::function<void(int)> on_close_;
 
     std::unordered_set<int> watched_;
+    std::unordered_set<int> paused_;
   };
 } // namespace io
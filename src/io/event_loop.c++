@@ -0,0 +1,46 @@
+#include "event_loop.h++"
+
+#include <cerrno>
+
+#include "epoll/epoll.h++"
+#include "uring/uring.h++"
+
+namespace io
+{
+  auto event_loop::make(const backend preferred) -> std::unique_ptr<event_loop>
+  {
+    if (preferred == backend::uring && uring::is_supported()) return std::make_unique<uring>();
+
+    return std::make_unique<epoll>();
+  }
+
+  auto event_loop::write_some(const int socket, iovec *iov, int count) -> ssize_t
+  {
+    ssize_t total = 0;
+    while (count > 0)
+    {
+      const auto r = ::writev(socket, iov, count);
+      if (r == -1)
+      {
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return total;
+        return -1;
+      }
+
+      total += r;
+      std::size_t sent = r;
+      while (count > 0 && sent >= iov->iov_len)
+      {
+        sent -= iov->iov_len;
+        ++iov;
+        --count;
+      }
+      if (count > 0)
+      {
+        iov->iov_base = static_cast<char *>(iov->iov_base) + sent;
+        iov->iov_len -= sent;
+      }
+    }
+    return total;
+  }
+} // namespace io
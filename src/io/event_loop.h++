@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace io
+{
+  /**
+   * @brief      Event loop of one reactor: accepts peers of the master
+   *             socket, delivers received bytes and writes responses.
+   *
+   * @details    Readiness (epoll) and completion (io_uring) backends share
+   *             this interface. The loop owns accepted sockets: a socket is
+   *             closed by unwatch() or when the peer is gone (on_close). A
+   *             peer that only shut down its sending side stays open for
+   *             writes when on_eof is set.
+   *             All callbacks run on the thread calling wait().
+   */
+  class event_loop
+  {
+  public:
+    enum class backend : uint8_t
+    {
+      epoll = 0,
+      uring = 1,
+    };
+
+    /**
+     * send() result: all bytes are taken by the backend and written
+     * asynchronously, on_writable() reports the end of the write
+     */
+    constexpr static ssize_t QUEUED = -2;
+
+  public:
+    virtual ~event_loop() = default;
+
+    /**
+     * @brief      Create the preferred backend, epoll when the kernel lacks
+     *             io_uring (or the features the backend relies on)
+     *
+     * @param[in]  preferred  The preferred backend
+     *
+     * @return     Not created loop, see create()
+     */
+    static auto make(const backend preferred) -> std::unique_ptr<event_loop>;
+
+    virtual auto get_backend() -> backend = 0;
+
+    /**
+     * @throws     std::runtime_error  Error create
+     */
+    virtual auto create() -> void = 0;
+
+    /**
+     * @brief      Wait and dispatch events once
+     *
+     * @throws     std::runtime_error  Wait error or master socket not defined
+     */
+    virtual auto wait() -> void = 0;
+
+    /**
+     * @brief      Close the loop and connected sockets
+     */
+    virtual auto shutdown() -> void = 0;
+
+    /**
+     * @brief      Listen socket, non blocking. One socket per instance
+     */
+    virtual auto register_master(const int socket) -> void = 0;
+
+    /**
+     * @brief      Stop watching the peer and close it
+     */
+    virtual auto unwatch(const int socket) -> void = 0;
+
+    /**
+     * @brief      Longest time wait() is blocked, in ms
+     */
+    virtual auto set_timeout(const int ms) -> void = 0;
+
+    /**
+     * @brief      Write buffers to the peer (iov is modified)
+     *
+     * @return     Bytes written before the socket got full (the caller keeps
+     *             the rest until on_writable), QUEUED or -1 on error
+     */
+    virtual auto send(const int socket, iovec *iov, const int count) -> ssize_t { return write_some(socket, iov, count); }
+
+    /**
+     * @brief      Write buffers and close the peer after them. The loop
+     *             copies the bytes, the caller forgets the peer.
+     *
+     * @return     false when the backend can not do it, nothing is written
+     */
+    virtual auto send_close(const int, const iovec *, const int) -> bool { return false; }
+
+    /**
+     * @brief      Caller keeps unsent bytes, on_writable() is wanted
+     */
+    virtual auto want_writable(const int) -> void {}
+
+    /**
+     * @brief      Stop reading the peer until resume_read(), bytes wait in
+     *             the socket buffer
+     */
+    virtual auto pause_read(const int) -> void {}
+
+    virtual auto resume_read(const int) -> void {}
+
+    /**
+     * @brief      A new peer is accepted
+     */
+    auto on_connection(std::function<void(int)> &&callback) -> void { on_connection_ = callback; }
+
+    /**
+     * @brief      Bytes received from the peer, a part of message
+     */
+    auto on_data(std::function<void(int, const char *, std::size_t)> &&callback) -> void { on_data_ = callback; }
+
+    /**
+     * @brief      Peer may accept more data or queued write is done
+     */
+    auto on_writable(std::function<void(int)> &&callback) -> void { on_writable_ = callback; }
+
+    /**
+     * @brief      Peer is closed by the other side or on error
+     */
+    auto on_close(std::function<void(int)> &&callback) -> void { on_close_ = callback; }
+
+    /**
+     * @brief      Peer will send no more data, it is still open for writes.
+     *             Without the callback such a peer is closed
+     */
+    auto on_eof(std::function<void(int)> &&callback) -> void { on_eof_ = callback; }
+
+  protected:
+    /**
+     * @brief      writev until done or EAGAIN
+     *
+     * @return     Bytes written or -1 on error
+     */
+    static auto write_some(const int socket, iovec *iov, int count) -> ssize_t;
+
+  protected:
+    std::function<void(int)> on_connection_;
+    std::function<void(int, const char *, std::size_t)> on_data_;
+    std::function<void(int)> on_writable_;
+    std::function<void(int)> on_close_;
+    std::function<void(int)> on_eof_;
+  };
+} // namespace io
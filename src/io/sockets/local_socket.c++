@@ -5,9 +5,10 @@
 
 namespace io
 {
-  local_socket::local_socket(const char *path)
+  local_socket::local_socket(const char *path, const int type)
       : path_(path)
   {
+    type_ = type;
     state_ = states::noinit;
     fd = -1;
     readBuf.clear();
@@ -21,7 +22,6 @@ namespace io
   auto local_socket::open() -> bool
   {
     domain_ = AF_UNIX;
-    type_ = SOCK_SEQPACKET;
     proto_ = 0;
 
     if (state_ >= states::opened) return true;
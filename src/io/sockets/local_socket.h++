@@ -9,7 +9,11 @@ namespace io
   class local_socket : public io::socket
   {
   public:
-    local_socket(const char *path);
+    /**
+     * @param[in]  path  The socket file
+     * @param[in]  type  SOCK_SEQPACKET or SOCK_STREAM (HTTP server)
+     */
+    local_socket(const char *path, const int type = SOCK_SEQPACKET);
 
     ~local_socket() override;
 
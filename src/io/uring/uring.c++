@@ -0,0 +1,562 @@
+#include "uring.h++"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utils/metrics.h++>
+
+namespace io
+{
+  namespace
+  {
+    constexpr unsigned SETUP_FLAGS = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+
+    auto sys_setup(const unsigned entries, io_uring_params *params) -> int
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    auto sys_enter(const int fd, const unsigned submit, const unsigned wait_nr, const unsigned flags, void *arg,
+                   const std::size_t size) -> int
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submit, wait_nr, flags, arg, size));
+    }
+
+    auto sys_register(const int fd, const unsigned op, void *arg, const unsigned nr) -> int
+    {
+      return static_cast<int>(::syscall(__NR_io_uring_register, fd, op, arg, nr));
+    }
+
+    auto at(void *base, const unsigned offset) -> unsigned *
+    {
+      return reinterpret_cast<unsigned *>(static_cast<char *>(base) + offset);
+    }
+  } // namespace
+
+  uring::uring()
+      : fd_(-1)
+      , master_(-1)
+      , timeout_(WAIT_TIMEOUT_DEFAULT)
+      , watched_(0)
+      , pending_(0)
+      , closes_(0)
+      , sq_ptr_(MAP_FAILED)
+      , sq_size_(0)
+      , sq_head_(nullptr)
+      , sq_tail_(nullptr)
+      , sq_mask_(0)
+      , sq_entries_(0)
+      , sq_array_(nullptr)
+      , sqes_(static_cast<io_uring_sqe *>(MAP_FAILED))
+      , sqes_size_(0)
+      , cq_ptr_(MAP_FAILED)
+      , cq_size_(0)
+      , cq_head_(nullptr)
+      , cq_tail_(nullptr)
+      , cq_mask_(0)
+      , cqes_(nullptr)
+      , buf_ring_(static_cast<io_uring_buf_ring *>(MAP_FAILED))
+      , buf_ring_size_(0)
+      , buf_tail_(0)
+      , buffers_()
+      , peers_()
+  {
+  }
+
+  uring::~uring()
+  {
+    release();
+  }
+
+  auto uring::is_supported() -> bool
+  {
+    static const bool supported = []()
+    {
+      // SINGLE_ISSUER came with 6.0 as multishot recv and cancel by fd,
+      // provided buffer rings and multishot accept are 5.19
+      io_uring_params params{};
+      params.flags = IORING_SETUP_SINGLE_ISSUER;
+      const int fd = sys_setup(ENTRIES, &params);
+      if (fd == -1) return false;
+      ::close(fd);
+
+      constexpr unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+      return (params.features & required) == required;
+    }();
+
+    return supported;
+  }
+
+  auto uring::create() -> void
+  {
+    io_uring_params params{};
+    params.flags = SETUP_FLAGS;
+    params.cq_entries = CQ_ENTRIES;
+    fd_ = sys_setup(ENTRIES, &params);
+    if (fd_ == -1) throw std::runtime_error(std::string("[Uring] create error: ") + std::strerror(errno));
+
+    // one mapping for both rings (IORING_FEAT_SINGLE_MMAP)
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sq_size_ = std::max(sq_size_, cq_size_);
+    sq_ptr_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) throw std::runtime_error("[Uring] map rings error");
+    cq_ptr_ = sq_ptr_;
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe *>(
+        ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) throw std::runtime_error("[Uring] map sqes error");
+
+    sq_head_ = at(sq_ptr_, params.sq_off.head);
+    sq_tail_ = at(sq_ptr_, params.sq_off.tail);
+    sq_mask_ = *at(sq_ptr_, params.sq_off.ring_mask);
+    sq_entries_ = *at(sq_ptr_, params.sq_off.ring_entries);
+    sq_array_ = at(sq_ptr_, params.sq_off.array);
+    // sqe index i always sits in the slot i of the array
+    for (unsigned i = 0; i < sq_entries_; ++i)
+    {
+      sq_array_[i] = i;
+    }
+
+    cq_head_ = at(cq_ptr_, params.cq_off.head);
+    cq_tail_ = at(cq_ptr_, params.cq_off.tail);
+    cq_mask_ = *at(cq_ptr_, params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(cq_ptr_) + params.cq_off.cqes);
+
+    // provided buffers: ring of descriptors shared with the kernel
+    buf_ring_size_ = BUFFERS * sizeof(io_uring_buf);
+    buf_ring_ = static_cast<io_uring_buf_ring *>(
+        ::mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (buf_ring_ == MAP_FAILED) throw std::runtime_error("[Uring] map buffer ring error");
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = BUFFERS;
+    reg.bgid = BUFFER_GROUP;
+    if (sys_register(fd_, IORING_REGISTER_PBUF_RING, &reg, 1) == -1)
+    {
+      throw std::runtime_error(std::string("[Uring] register buffers error: ") + std::strerror(errno));
+    }
+
+    buffers_.resize(BUFFERS * BUFFER_SIZE);
+    for (unsigned i = 0; i < BUFFERS; ++i)
+    {
+      recycle(i);
+    }
+  }
+
+  auto uring::wait() -> void
+  {
+    if (master_ == -1) throw std::runtime_error("[Uring] master socket not defined.");
+
+    const bool ready = *cq_head_ != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if ((!ready || pending_ > 0) && submit(ready ? 0 : 1) == -1 && errno != ETIME && errno != EINTR && errno != EBUSY)
+    {
+      throw std::runtime_error(std::string("[Uring] wait error: ") + std::strerror(errno));
+    }
+
+    // callbacks may queue new requests, completions are taken one by one
+    unsigned head = *cq_head_;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+    {
+      const auto cqe = cqes_[head & cq_mask_];
+      __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+      dispatch(cqe);
+      head = *cq_head_;
+    }
+  }
+
+  auto uring::shutdown() -> void
+  {
+    for (std::size_t fd = 0; fd < peers_.size(); ++fd)
+    {
+      if (peers_[fd].open) arm_close(fd);
+    }
+    release();
+    if (master_ != -1) ::close(master_);
+    master_ = -1;
+  }
+
+  auto uring::register_master(const int socket) -> void
+  {
+    if (master_ != -1) return;
+    master_ = socket;
+    arm_accept();
+  }
+
+  auto uring::unwatch(const int socket) -> void
+  {
+    if (socket < 0 || static_cast<std::size_t>(socket) >= peers_.size()) return;
+    if (!peers_[socket].open) return;
+
+    arm_close(socket);
+  }
+
+  auto uring::send(const int socket, iovec *iov, const int count) -> ssize_t
+  {
+    auto &p = get_peer(socket);
+    // a send of the previous peer with this fd may still use the buffer
+    if (!p.open || p.sending || !copy(p, iov, count)) return write_some(socket, iov, count);
+
+    p.sending = true;
+    arm_send(socket, 0);
+    return QUEUED;
+  }
+
+  auto uring::send_close(const int socket, const iovec *iov, const int count) -> bool
+  {
+    auto &p = get_peer(socket);
+    if (!p.open || p.sending || !copy(p, iov, count)) return false;
+
+    // hard links: close runs even if send fails
+    p.sending = true;
+    reserve(3);
+    arm_send(socket, IOSQE_IO_HARDLINK);
+    arm_close(socket);
+    return true;
+  }
+
+  auto uring::want_writable(const int socket) -> void
+  {
+    auto &p = get_peer(socket);
+    if (!p.open || p.polling) return;
+
+    p.polling = true;
+    auto sqe = get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = socket;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = make_data(ops::poll, p.gen, socket);
+  }
+
+  auto uring::pause_read(const int socket) -> void
+  {
+    auto &p = get_peer(socket);
+    if (!p.open || p.paused) return;
+
+    p.paused = true;
+    if (!p.receiving) return;
+
+    auto sqe = get_sqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = make_data(ops::recv, p.gen, socket);
+    sqe->user_data = make_data(ops::cancel, p.gen, socket);
+  }
+
+  auto uring::resume_read(const int socket) -> void
+  {
+    auto &p = get_peer(socket);
+    if (!p.open || !p.paused) return;
+
+    p.paused = false;
+    // a recv still running was not cancelled yet, see on_recv
+    if (!p.receiving) arm_recv(socket);
+  }
+
+  auto uring::get_sqe() -> io_uring_sqe *
+  {
+    // no SQPOLL: kernel reads the queue in io_uring_enter only, the tail may
+    // be published before the entry is filled
+    reserve(1);
+    const unsigned tail = *sq_tail_;
+    auto sqe = &sqes_[tail & sq_mask_];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++pending_;
+    return sqe;
+  }
+
+  auto uring::reserve(const unsigned count) -> void
+  {
+    // the kernel may take a part of the queue (or nothing on EBUSY), a slot
+    // is handed out only when it is consumed
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    while (*sq_tail_ - head + count > sq_entries_)
+    {
+      if (submit(0) == -1 && errno != EBUSY && errno != EAGAIN)
+      {
+        throw std::runtime_error(std::string("[Uring] submit error: ") + std::strerror(errno));
+      }
+
+      const unsigned consumed = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+      if (consumed == head) throw std::runtime_error("[Uring] submission queue is full");
+      head = consumed;
+    }
+  }
+
+  auto uring::submit(const unsigned wait_nr) -> int
+  {
+    unsigned flags = 0;
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    if (wait_nr > 0)
+    {
+      ts.tv_sec = timeout_ / 1000;
+      ts.tv_nsec = (timeout_ % 1000) * 1000000LL;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+      flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    }
+
+    int r;
+    do
+    {
+      r = sys_enter(fd_, pending_, wait_nr, flags, flags ? &arg : nullptr, flags ? sizeof(arg) : 0);
+    } while (r == -1 && errno == EINTR && wait_nr == 0);
+
+    if (r >= 0) pending_ -= std::min<unsigned>(r, pending_);
+    return r;
+  }
+
+  auto uring::dispatch(const io_uring_cqe &cqe) -> void
+  {
+    const auto op = static_cast<ops>(cqe.user_data >> 56);
+    const auto gen = static_cast<uint32_t>(cqe.user_data >> 32) & 0xffffff;
+    const auto fd = static_cast<int>(cqe.user_data & 0xffffffff);
+
+    switch (op)
+    {
+    case ops::accept:
+      on_accept(cqe);
+      break;
+    case ops::recv:
+    {
+      auto &p = get_peer(fd);
+      if (p.gen == gen && p.open) on_recv(fd, p, cqe);
+      if (cqe.flags & IORING_CQE_F_BUFFER) recycle(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+      break;
+    }
+    case ops::send:
+    {
+      auto &p = get_peer(fd);
+      // only one send per fd is in flight, stale or not
+      p.sending = false;
+      if (p.gen == gen && p.open) on_send(fd, p, cqe);
+      break;
+    }
+    case ops::poll:
+    {
+      auto &p = get_peer(fd);
+      if (p.gen != gen) break;
+      p.polling = false;
+      if (p.open && on_writable_) on_writable_(fd);
+      break;
+    }
+    case ops::close:
+      --closes_;
+      break;
+    case ops::cancel:
+      break;
+    }
+  }
+
+  auto uring::on_accept(const io_uring_cqe &cqe) -> void
+  {
+    // accept itself runs in the kernel, this is the connection setup
+    METRICS_TIME(accept);
+    if (cqe.res >= 0)
+    {
+      const int fd = cqe.res;
+      auto &p = get_peer(fd);
+      p.gen = (p.gen + 1) & 0xffffff;
+      p.open = true;
+      p.polling = false;
+      p.paused = false;
+      ++watched_;
+
+      arm_recv(fd);
+      if (on_connection_) on_connection_(fd);
+    }
+
+    // multishot accept stops on error or overflow
+    if (!(cqe.flags & IORING_CQE_F_MORE) && master_ != -1) arm_accept();
+  }
+
+  auto uring::on_recv(const int fd, peer &p, const io_uring_cqe &cqe) -> void
+  {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) p.receiving = false;
+
+    if (cqe.res > 0)
+    {
+      const uint16_t bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+      if (on_data_) on_data_(fd, buffers_.data() + bid * BUFFER_SIZE, cqe.res);
+
+      // peer closed by the callback
+      if (!peers_[fd].open) return;
+      if (!peers_[fd].receiving && !peers_[fd].paused) arm_recv(fd);
+      return;
+    }
+
+    // out of buffers, they are back in the ring after this completion;
+    // cancelled by pause_read, the peer may be resumed meanwhile
+    if (cqe.res == -ENOBUFS || cqe.res == -ECANCELED)
+    {
+      if (!p.paused) arm_recv(fd);
+      return;
+    }
+
+    // end of stream ends the multishot recv, the peer stays open for writes
+    if (cqe.res == 0 && on_eof_)
+    {
+      on_eof_(fd);
+      return;
+    }
+
+    arm_close(fd);
+    if (on_close_) on_close_(fd);
+  }
+
+  auto uring::on_send(const int fd, peer &p, const io_uring_cqe &cqe) -> void
+  {
+    if (cqe.res <= 0)
+    {
+      arm_close(fd);
+      if (on_close_) on_close_(fd);
+      return;
+    }
+
+    p.sent += cqe.res;
+    if (p.sent < p.out.size())
+    {
+      p.sending = true;
+      arm_send(fd, 0);
+      return;
+    }
+
+    if (on_writable_) on_writable_(fd);
+  }
+
+  auto uring::arm_accept() -> void
+  {
+    auto sqe = get_sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = master_;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = make_data(ops::accept, 0, master_);
+  }
+
+  auto uring::arm_recv(const int fd) -> void
+  {
+    auto sqe = get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = make_data(ops::recv, peers_[fd].gen, fd);
+    peers_[fd].receiving = true;
+  }
+
+  auto uring::arm_send(const int fd, const uint8_t flags) -> void
+  {
+    const auto &p = peers_[fd];
+    auto sqe = get_sqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->flags = flags;
+    sqe->addr = reinterpret_cast<uint64_t>(p.out.data() + p.sent);
+    sqe->len = p.out.size() - p.sent;
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = make_data(ops::send, p.gen, fd);
+  }
+
+  auto uring::arm_close(const int fd) -> void
+  {
+    auto &p = peers_[fd];
+    p.open = false;
+    --watched_;
+
+    // pending recv and poll hold the socket, close alone would not release it
+    reserve(2);
+    auto cancel = get_sqe();
+    cancel->opcode = IORING_OP_ASYNC_CANCEL;
+    cancel->fd = fd;
+    cancel->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    cancel->flags = IOSQE_IO_HARDLINK;
+    cancel->user_data = make_data(ops::cancel, p.gen, fd);
+
+    auto close = get_sqe();
+    close->opcode = IORING_OP_CLOSE;
+    close->fd = fd;
+    close->user_data = make_data(ops::close, p.gen, fd);
+    ++closes_;
+  }
+
+  auto uring::recycle(const uint16_t bid) -> void
+  {
+    // entries start at the ring start, the uapi flexible array member is
+    // shifted by the empty struct it is declared with in C++
+    auto &buf = reinterpret_cast<io_uring_buf *>(buf_ring_)[buf_tail_ & (BUFFERS - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffers_.data() + bid * BUFFER_SIZE);
+    buf.len = BUFFER_SIZE;
+    buf.bid = bid;
+    __atomic_store_n(&buf_ring_->tail, ++buf_tail_, __ATOMIC_RELEASE);
+  }
+
+  auto uring::get_peer(const int fd) -> peer &
+  {
+    if (static_cast<std::size_t>(fd) >= peers_.size()) peers_.resize(fd + 1);
+    return peers_[fd];
+  }
+
+  auto uring::copy(peer &p, const iovec *iov, const int count) -> bool
+  {
+    std::size_t total = 0;
+    for (int i = 0; i < count; ++i)
+    {
+      total += iov[i].iov_len;
+    }
+    if (total > SEND_COPY_LIMIT) return false;
+
+    p.out.clear();
+    p.sent = 0;
+    for (int i = 0; i < count; ++i)
+    {
+      p.out.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return true;
+  }
+
+  auto uring::release() -> void
+  {
+    if (fd_ == -1) return;
+
+    // closes are queued requests, the ring must run them before it is gone
+    const int timeout = timeout_;
+    timeout_ = 10;
+    for (int i = 0; cq_head_ && (closes_ > 0 || pending_ > 0) && i < 100; ++i)
+    {
+      if (submit(1) == -1 && errno != ETIME && errno != EINTR) break;
+
+      unsigned head = *cq_head_;
+      while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+      {
+        if (static_cast<ops>(cqes_[head & cq_mask_].user_data >> 56) == ops::close) --closes_;
+        __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+      }
+    }
+    timeout_ = timeout;
+
+    if (buf_ring_ != MAP_FAILED) ::munmap(buf_ring_, buf_ring_size_);
+    if (sqes_ != MAP_FAILED) ::munmap(sqes_, sqes_size_);
+    if (sq_ptr_ != MAP_FAILED) ::munmap(sq_ptr_, sq_size_);
+    buf_ring_ = static_cast<io_uring_buf_ring *>(MAP_FAILED);
+    sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+    sq_ptr_ = cq_ptr_ = MAP_FAILED;
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+  auto uring::make_data(const ops op, const uint32_t gen, const int fd) -> uint64_t
+  {
+    return static_cast<uint64_t>(op) << 56 | static_cast<uint64_t>(gen & 0xffffff) << 32 |
+           static_cast<uint32_t>(fd);
+  }
+} // namespace io
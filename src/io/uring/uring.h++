@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <string>
+#include <vector>
+
+#include "../event_loop.h++"
+
+namespace io
+{
+  /**
+   * @brief      io_uring event loop. Linux 6.0+.
+   *
+   * @details    One multishot accept serves the master socket and every peer
+   *             has one multishot recv that takes buffers from a provided
+   *             buffer ring, so receiving costs no syscall per read and no
+   *             epoll_ctl per peer. Small responses are copied to a per-peer
+   *             buffer and sent from the ring; the last response of a peer
+   *             is linked with cancel and close. Submissions are flushed by
+   *             the io_uring_enter that waits for completions.
+   * @see        man io_uring
+   */
+  class uring final : public event_loop
+  {
+  public:
+    uring();
+
+    ~uring();
+
+    /**
+     * @brief      Kernel has io_uring with multishot accept/recv and
+     *             provided buffer rings (checked once)
+     */
+    static auto is_supported() -> bool;
+
+    auto get_backend() -> backend override { return backend::uring; }
+
+    /**
+     * @brief      Create ring and register provided buffers
+     *
+     * @throws     std::runtime_error  Error create
+     */
+    auto create() -> void override;
+
+    /**
+     * @brief      Submit queued requests, wait for completions and dispatch
+     *             them
+     *
+     * @throws     std::runtime_error  Wait error or master socket not defined
+     */
+    auto wait() -> void override;
+
+    auto shutdown() -> void override;
+
+    auto register_master(const int socket) -> void override;
+
+    /**
+     * @brief      Cancel requests of the peer and close it. Peer already
+     *             closing by send_close() is skipped.
+     */
+    auto unwatch(const int socket) -> void override;
+
+    auto set_timeout(const int ms) -> void override { timeout_ = ms; }
+
+    /**
+     * @brief      Responses up to SEND_COPY_LIMIT are queued, larger ones
+     *             are written at once like with epoll
+     */
+    auto send(const int socket, iovec *iov, const int count) -> ssize_t override;
+
+    /**
+     * @brief      send, cancel and close linked in one chain
+     */
+    auto send_close(const int socket, const iovec *iov, const int count) -> bool override;
+
+    /**
+     * @brief      One-shot POLLOUT poll of the peer
+     */
+    auto want_writable(const int socket) -> void override;
+
+    /**
+     * @brief      Cancel the multishot recv, completions already posted are
+     *             still delivered
+     */
+    auto pause_read(const int socket) -> void override;
+
+    auto resume_read(const int socket) -> void override;
+
+    auto watched_size() -> int { return watched_; }
+
+  private:
+    enum class ops : uint8_t
+    {
+      accept = 1,
+      recv = 2,
+      send = 3,
+      poll = 4,
+      close = 5,
+      cancel = 6,
+    };
+
+    /**
+     * State of a peer, indexed by fd. Generation is changed on every
+     * accept, completions of the previous peer with the same fd are stale.
+     */
+    struct peer
+    {
+      uint32_t gen = 0;
+      bool open = false;
+      bool polling = false;
+      bool receiving = false; // multishot recv is armed
+      bool paused = false;
+      bool sending = false; // out is in use by the kernel
+      std::string out;
+      std::size_t sent = 0;
+    };
+
+    auto get_sqe() -> io_uring_sqe *;
+
+    /**
+     * @brief      Make room for a chain of linked requests, so it is never
+     *             split between submissions
+     *
+     * @throws     std::runtime_error  The kernel takes no entries
+     */
+    auto reserve(const unsigned count) -> void;
+
+    auto submit(const unsigned wait_nr) -> int;
+
+    auto dispatch(const io_uring_cqe &cqe) -> void;
+
+    auto on_accept(const io_uring_cqe &cqe) -> void;
+
+    auto on_recv(const int fd, peer &p, const io_uring_cqe &cqe) -> void;
+
+    auto on_send(const int fd, peer &p, const io_uring_cqe &cqe) -> void;
+
+    auto arm_accept() -> void;
+
+    auto arm_recv(const int fd) -> void;
+
+    auto arm_send(const int fd, const uint8_t flags) -> void;
+
+    /**
+     * @brief      Cancel all requests on fd, then close it
+     */
+    auto arm_close(const int fd) -> void;
+
+    auto recycle(const uint16_t bid) -> void;
+
+    auto get_peer(const int fd) -> peer &;
+
+    /**
+     * @brief      Copy buffers to the peer output
+     *
+     * @return     false when total size is over SEND_COPY_LIMIT
+     */
+    auto copy(peer &p, const iovec *iov, const int count) -> bool;
+
+    /**
+     * @brief      Wait for pending closes and release the ring
+     */
+    auto release() -> void;
+
+    static auto make_data(const ops op, const uint32_t gen, const int fd) -> uint64_t;
+
+  private:
+    constexpr static unsigned ENTRIES = 256;
+    constexpr static unsigned CQ_ENTRIES = 4096;
+    constexpr static unsigned BUFFERS = 256; // provided buffers, power of two
+    constexpr static unsigned BUFFER_SIZE = 4096;
+    constexpr static uint16_t BUFFER_GROUP = 0;
+    constexpr static std::size_t SEND_COPY_LIMIT = 1024 * 64;
+    constexpr static int WAIT_TIMEOUT_DEFAULT = 0x3e8; // 1s
+
+    int fd_;
+    int master_;
+    int timeout_;
+    int watched_;
+    unsigned pending_; // prepared sqes not submitted yet
+    unsigned closes_;  // close requests in flight
+
+    // submission queue
+    void *sq_ptr_;
+    std::size_t sq_size_;
+    unsigned *sq_head_;
+    unsigned *sq_tail_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    unsigned *sq_array_;
+    io_uring_sqe *sqes_;
+    std::size_t sqes_size_;
+
+    // completion queue
+    void *cq_ptr_;
+    std::size_t cq_size_;
+    unsigned *cq_head_;
+    unsigned *cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe *cqes_;
+
+    // provided buffers
+    io_uring_buf_ring *buf_ring_;
+    std::size_t buf_ring_size_;
+    uint16_t buf_tail_;
+    std::vector<char> buffers_;
+
+    std::vector<peer> peers_;
+  };
+} // namespace io
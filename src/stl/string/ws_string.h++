@@ -2,6 +2,7 @@
 
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace ws_stl
@@ -40,19 +41,48 @@ namespace ws_stl
 
   inline auto to_upper(const std::string &str) -> const std::string
   {
-    char *chr = const_cast<char *>(str.c_str());
-    while (*chr)
-      *(chr++) = toupper((unsigned char)*chr);
+    std::string result(str);
+    for (auto &chr : result)
+      chr = toupper((unsigned char)chr);
 
-    return str;
+    return result;
   }
 
   inline auto to_lower(const std::string &str) -> const std::string
   {
-    char *chr = const_cast<char *>(str.c_str());
-    while (*chr)
-      *(chr++) = tolower((unsigned char)*chr);
+    std::string result(str);
+    for (auto &chr : result)
+      chr = tolower((unsigned char)chr);
+
+    return result;
+  }
+
+  inline auto iequals(std::string_view a, std::string_view b) -> bool
+  {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+      if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    }
+    return true;
+  }
+
+  inline auto icontains(std::string_view str, std::string_view needle) -> bool
+  {
+    if (needle.size() > str.size()) return false;
+    for (std::size_t i = 0; i + needle.size() <= str.size(); ++i)
+    {
+      if (iequals(str.substr(i, needle.size()), needle)) return true;
+    }
+    return false;
+  }
 
+  inline auto trim_view(std::string_view str) -> std::string_view
+  {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+      str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+      str.remove_suffix(1);
     return str;
   }
 } // namespace ws_stl
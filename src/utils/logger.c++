@@ -1,9 +1,528 @@
 #include "logger.h++"
 
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "spsc_ring.h++"
+
 namespace utils
 {
 
   // Initialize the default log level to INFO
   LogLevel Logger::min_level_ = LogLevel::INFO;
+  std::atomic<bool> Logger::async_{false};
+  std::atomic<bool> Logger::access_log_{false};
+
+  namespace
+  {
+    constexpr std::size_t BATCH_SIZE = 64 * 1024; // written at once when reached
+    constexpr const char *LEVEL_NAMES[] = {"debug", "info", "warn", "error"};
+
+    /**
+     * Ring of one thread. Owned by the writer, the thread marks it closed
+     * on exit and the writer frees it once it is drained.
+     */
+    struct ThreadRing
+    {
+      explicit ThreadRing(const std::size_t size)
+          : ring(size)
+      {
+      }
+
+      spsc_ring<LogRecord> ring;
+      std::atomic<uint64_t> dropped{0};
+      std::atomic<bool> closed{false};
+    };
+
+    struct RingHandle
+    {
+      ThreadRing *ring = nullptr;
+      uint64_t epoch = 0;
+
+      ~RingHandle()
+      {
+        if (ring)
+        {
+          ring->closed.store(true, std::memory_order_release);
+        }
+      }
+    };
+
+    thread_local RingHandle handle;
+
+    // write all of buffer, false on error
+    auto write_all(const int fd, const std::string &buffer) -> bool
+    {
+      std::size_t done = 0;
+      while (done < buffer.size())
+      {
+        const auto r = ::write(fd, buffer.data() + done, buffer.size() - done);
+        if (r == -1)
+        {
+          if (errno == EINTR) continue;
+          return false;
+        }
+        done += r;
+      }
+      return true;
+    }
+
+    auto append_json(std::string &out, std::string_view value) -> void
+    {
+      for (const char c : value)
+      {
+        switch (c)
+        {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20)
+          {
+            fmt::format_to(std::back_inserter(out), "\\u{:04x}", c);
+            break;
+          }
+          out.push_back(c);
+        }
+      }
+    }
+  } // namespace
+
+  /**
+   * @brief Writer thread of the async mode
+   */
+  class AsyncLogWriter
+  {
+  public:
+    static AsyncLogWriter &get()
+    {
+      static AsyncLogWriter instance;
+      return instance;
+    }
+
+    ~AsyncLogWriter() { stop(); }
+
+    bool start(const AsyncOptions &options)
+    {
+      stop();
+
+      // the writer reads options_ only, it is started after them; logging
+      // threads of the previous run may still read the atomics
+      options_ = options;
+      overflow_.store(options.overflow, std::memory_order_relaxed);
+      ring_size_.store(options.ring_size, std::memory_order_relaxed);
+      if (!options_.path.empty() && !open_file())
+      {
+        return false;
+      }
+
+      // console output of the sync mode goes first
+      std::fflush(stdout);
+      std::fflush(stderr);
+      shared_console_ = is_same_file(STDOUT_FILENO, STDERR_FILENO);
+
+      epoch_.fetch_add(1, std::memory_order_relaxed);
+      running_ = true;
+      flushed_ = requested_;
+      thread_ = std::thread(&AsyncLogWriter::run, this);
+
+      Logger::access_log_.store(options_.access_log, std::memory_order_relaxed);
+      Logger::async_.store(true, std::memory_order_release);
+      return true;
+    }
+
+    void stop()
+    {
+      if (!thread_.joinable())
+      {
+        return;
+      }
+
+      Logger::async_.store(false, std::memory_order_relaxed);
+      Logger::access_log_.store(false, std::memory_order_relaxed);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+      }
+      wake_.notify_all();
+      thread_.join();
+
+      if (fd_ != -1)
+      {
+        ::close(fd_);
+        fd_ = -1;
+      }
+    }
+
+    void flush()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!running_)
+      {
+        return;
+      }
+
+      const auto target = ++requested_;
+      wake_.notify_all();
+      flushed_cv_.wait(lock, [this, target]() { return flushed_ >= target || !running_; });
+    }
+
+    LogRecord *acquire(const LogLevel level, const LogRecord::Kind kind)
+    {
+      const auto epoch = epoch_.load(std::memory_order_relaxed);
+      if (!handle.ring || handle.epoch != epoch)
+      {
+        attach(epoch);
+      }
+
+      auto *ring = handle.ring;
+      auto *record = ring->ring.claim();
+      while (!record)
+      {
+        if (overflow_.load(std::memory_order_relaxed) == LogOverflow::DROP)
+        {
+          ring->dropped.fetch_add(1, std::memory_order_relaxed);
+          return nullptr;
+        }
+
+        // writer may be stopped meanwhile
+        if (!Logger::is_async())
+        {
+          return nullptr;
+        }
+        wake();
+        std::this_thread::yield();
+        record = ring->ring.claim();
+      }
+
+      record->time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+      record->level = level;
+      record->kind = kind;
+      record->truncated = false;
+      record->size = 0;
+      return record;
+    }
+
+    void commit() { handle.ring->ring.publish(); }
+
+  private:
+    AsyncLogWriter() = default;
+
+    void wake()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nudged_ = true;
+      }
+      wake_.notify_one();
+    }
+
+    // new ring for the calling thread, the previous one is freed when drained
+    void attach(const uint64_t epoch)
+    {
+      auto ring = std::make_unique<ThreadRing>(ring_size_.load(std::memory_order_relaxed));
+      if (handle.ring)
+      {
+        handle.ring->closed.store(true, std::memory_order_release);
+      }
+      handle.ring = ring.get();
+      handle.epoch = epoch;
+
+      std::lock_guard<std::mutex> lock(rings_mutex_);
+      rings_.push_back(std::move(ring));
+    }
+
+    void run()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (true)
+      {
+        const bool stopping = !running_;
+        const auto requested = requested_;
+        lock.unlock();
+
+        drain();
+
+        lock.lock();
+        flushed_ = requested;
+        flushed_cv_.notify_all();
+        if (stopping)
+        {
+          break;
+        }
+        wake_.wait_for(lock, options_.flush_interval, [this, requested]() {
+          return !running_ || nudged_ || requested_ != requested;
+        });
+        nudged_ = false;
+      }
+    }
+
+    // one pass over all rings, then free rings of finished threads
+    void drain()
+    {
+      {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        pass_.clear();
+        for (const auto &ring : rings_)
+        {
+          pass_.push_back(ring.get());
+        }
+      }
+
+      for (auto *ring : pass_)
+      {
+        while (auto *record = ring->ring.front())
+        {
+          append(*record);
+          ring->ring.pop();
+          if (out_.size() + err_.size() >= BATCH_SIZE)
+          {
+            write();
+          }
+        }
+
+        const auto dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+          append_dropped(dropped);
+        }
+      }
+      write();
+
+      std::lock_guard<std::mutex> lock(rings_mutex_);
+      std::erase_if(rings_, [](const std::unique_ptr<ThreadRing> &ring) {
+        return ring->closed.load(std::memory_order_acquire) && ring->ring.size() == 0;
+      });
+    }
+
+    void append(const LogRecord &record)
+    {
+      const std::string_view text(record.text, record.size);
+      if (fd_ != -1)
+      {
+        append_time(record.time);
+        fmt::format_to(std::back_inserter(out_), ",\"level\":\"{}\"", LEVEL_NAMES[static_cast<int>(record.level)]);
+        if (record.kind == LogRecord::Kind::ACCESS)
+        {
+          out_.append(",\"type\":\"access\",\"method\":\"");
+          append_json(out_, text.substr(0, record.method_size));
+          out_.append("\",\"path\":\"");
+          append_json(out_, text.substr(record.method_size));
+          fmt::format_to(std::back_inserter(out_), "\",\"status\":{},\"bytes\":{},\"duration_us\":{}}}\n",
+              record.status, record.bytes, record.duration_us);
+          return;
+        }
+
+        out_.append(",\"message\":\"");
+        append_json(out_, text);
+        out_.append(record.truncated ? "\",\"truncated\":true}\n" : "\"}\n");
+        return;
+      }
+
+      // console: same text as the sync mode, one buffer in record order when
+      // stdout and stderr are the same file
+      auto &out = record.level >= LogLevel::WARN && !shared_console_ ? err_ : out_;
+      const std::chrono::system_clock::time_point time{
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(record.time))};
+      out.append(Logger::get_timestamp(time));
+      out.push_back(' ');
+      out.append(Logger::get_level_string(record.level));
+      out.push_back(' ');
+      if (record.kind == LogRecord::Kind::ACCESS)
+      {
+        fmt::format_to(std::back_inserter(out), "{} {} {} {}B {}us\n", text.substr(0, record.method_size),
+            text.substr(record.method_size), record.status, record.bytes, record.duration_us);
+        return;
+      }
+      out.append(text);
+      out.append(record.truncated ? "...\n" : "\n");
+    }
+
+    void append_dropped(const uint64_t dropped)
+    {
+      LogRecord record;
+      record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+      record.level = LogLevel::WARN;
+      record.kind = LogRecord::Kind::MESSAGE;
+      record.truncated = false;
+      const auto result =
+          fmt::format_to_n(record.text, LogRecord::TEXT_SIZE, "Log ring is full, dropped {} record(s)", dropped);
+      record.size = result.size;
+      append(record);
+    }
+
+    // {"time":"2024-01-01T00:00:00.000000000Z" with the date part formatted once per second
+    void append_time(const int64_t ns)
+    {
+      const time_t second = ns / 1000000000;
+      if (second != time_second_ || time_prefix_.empty())
+      {
+        std::tm tm{};
+        gmtime_r(&second, &tm);
+        time_second_ = second;
+        time_prefix_ = fmt::format("{{\"time\":\"{:%Y-%m-%dT%H:%M:%S}", tm);
+      }
+      out_.append(time_prefix_);
+      fmt::format_to(std::back_inserter(out_), ".{:09}Z\"", ns % 1000000000);
+    }
+
+    void write()
+    {
+      if (fd_ != -1)
+      {
+        if (!out_.empty())
+        {
+          if (options_.max_size > 0 && size_ > 0 && size_ + out_.size() > options_.max_size)
+          {
+            rotate();
+          }
+          if (fd_ != -1 && write_all(fd_, out_))
+          {
+            size_ += out_.size();
+          }
+        }
+      }
+      else
+      {
+        if (!out_.empty())
+        {
+          write_all(STDOUT_FILENO, out_);
+        }
+        if (!err_.empty())
+        {
+          write_all(STDERR_FILENO, err_);
+        }
+      }
+      out_.clear();
+      err_.clear();
+    }
+
+    static bool is_same_file(const int a, const int b)
+    {
+      struct stat sa;
+      struct stat sb;
+      return ::fstat(a, &sa) == 0 && ::fstat(b, &sb) == 0 && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+    }
+
+    bool open_file()
+    {
+      fd_ = ::open(options_.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+      if (fd_ == -1)
+      {
+        return false;
+      }
+
+      struct stat st;
+      size_ = ::fstat(fd_, &st) == 0 ? st.st_size : 0;
+      return true;
+    }
+
+    // path -> path.1 -> ... -> path.max_files, the oldest is overwritten
+    void rotate()
+    {
+      ::close(fd_);
+      fd_ = -1;
+
+      const auto &path = options_.path;
+      if (options_.max_files <= 0)
+      {
+        ::unlink(path.c_str());
+      }
+      for (int i = options_.max_files - 1; i >= 1; --i)
+      {
+        ::rename(fmt::format("{}.{}", path, i).c_str(), fmt::format("{}.{}", path, i + 1).c_str());
+      }
+      if (options_.max_files > 0)
+      {
+        ::rename(path.c_str(), fmt::format("{}.1", path).c_str());
+      }
+
+      open_file();
+    }
+
+  private:
+    AsyncOptions options_;
+    std::atomic<LogOverflow> overflow_{LogOverflow::DROP};
+    std::atomic<std::size_t> ring_size_{1024};
+    std::atomic<uint64_t> epoch_{0};
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_cv_;
+    bool running_ = false;
+    bool nudged_ = false;    // a blocked thread waits for room
+    uint64_t requested_ = 0; // flush() calls
+    uint64_t flushed_ = 0;
+
+    std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<ThreadRing>> rings_;
+    std::vector<ThreadRing *> pass_;
+
+    // sink
+    int fd_ = -1;
+    std::size_t size_ = 0;
+    std::string out_;
+    std::string err_;
+    bool shared_console_ = false; // stderr records go to out_
+    time_t time_second_ = 0;
+    std::string time_prefix_;
+  };
+
+  bool Logger::start_async(const AsyncOptions &options) { return AsyncLogWriter::get().start(options); }
+
+  void Logger::stop_async() { AsyncLogWriter::get().stop(); }
+
+  void Logger::flush() { AsyncLogWriter::get().flush(); }
+
+  void Logger::access(std::string_view method, std::string_view path, int status, std::size_t bytes,
+      std::chrono::microseconds duration)
+  {
+    if (!is_access_log())
+    {
+      return;
+    }
+
+    auto *record = acquire(LogLevel::INFO, LogRecord::Kind::ACCESS);
+    if (!record)
+    {
+      return;
+    }
+
+    // method is short, the path gets what is left
+    method = method.substr(0, 16);
+    path = path.substr(0, LogRecord::TEXT_SIZE - method.size());
+    std::memcpy(record->text, method.data(), method.size());
+    std::memcpy(record->text + method.size(), path.data(), path.size());
+    record->method_size = method.size();
+    record->size = method.size() + path.size();
+    record->status = status;
+    record->bytes = bytes;
+    record->duration_us = duration.count();
+    commit();
+  }
+
+  LogRecord *Logger::acquire(LogLevel level, LogRecord::Kind kind)
+  {
+    return AsyncLogWriter::get().acquire(level, kind);
+  }
+
+  void Logger::commit() { AsyncLogWriter::get().commit(); }
 
 } // namespace utils
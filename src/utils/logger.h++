@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <fmt/chrono.h>
 #include <fmt/color.h>
 #include <fmt/core.h>
+#include <iterator>
+#include <string>
 #include <string_view>
 
 namespace utils
@@ -20,12 +25,67 @@ namespace utils
     ERROR = 3
   };
 
+  /**
+   * @brief What the async logger does when the ring of a thread is full
+   */
+  enum class LogOverflow
+  {
+    DROP = 0, // count and report dropped records
+    BLOCK = 1 // wait for the writer thread
+  };
+
+  /**
+   * @brief Settings of the async logging mode
+   */
+  struct AsyncOptions
+  {
+    std::string path;                              // JSON lines file, empty prints text to the console
+    std::size_t max_size = 64 * 1024 * 1024;       // rotate before the file grows over it, 0 never
+    int max_files = 5;                             // rotated files kept: path.1 (newest) .. path.N
+    std::size_t ring_size = 1024;                  // records per thread
+    LogOverflow overflow = LogOverflow::DROP;      // full ring policy
+    bool access_log = false;                       // one record per served request
+    std::chrono::milliseconds flush_interval{10};  // writer wakeup period
+  };
+
+  /**
+   * @brief Fixed size slot of the per-thread ring, filled in place by the
+   * logging thread and written out by the writer thread
+   */
+  struct LogRecord
+  {
+    enum class Kind : uint8_t
+    {
+      MESSAGE = 0,
+      ACCESS = 1
+    };
+
+    static constexpr std::size_t TEXT_SIZE = 480;
+
+    int64_t time;         // system clock, ns since epoch
+    uint64_t bytes;       // access: response size
+    uint32_t duration_us; // access: time to serve
+    uint16_t size;        // used bytes of text
+    uint16_t status;      // access: status code
+    uint16_t method_size; // access: text is method followed by path
+    LogLevel level;
+    Kind kind;
+    bool truncated;
+    char text[TEXT_SIZE];
+  };
+
   /**
    * @brief Simple logging utility using fmt library
    *
    * This logger provides colored output with timestamps and log levels.
    * It uses the fmt library for efficient formatting and supports
    * different log levels with appropriate styling.
+   *
+   * By default every call formats and prints on the calling thread. After
+   * start_async() the calling thread only formats the message into its own
+   * lock-free ring; a writer thread drains all rings and writes each batch
+   * with one write(2), as text to the console or as JSON lines to a file
+   * rotated by size. Timestamps are formatted once per second.
    */
   class Logger
   {
@@ -42,6 +102,43 @@ namespace utils
      */
     static LogLevel get_level() { return min_level_; }
 
+    /**
+     * @brief Switch to async mode (restarts it when running). Call before
+     * the logging threads are busy, records of the previous mode are flushed.
+     * @param options Sink, ring and overflow settings
+     * @return false when the log file can not be opened
+     */
+    static bool start_async(const AsyncOptions &options);
+
+    /**
+     * @brief Write pending records, stop the writer and go back to the
+     * synchronous mode
+     */
+    static void stop_async();
+
+    /**
+     * @brief Block until records logged before the call are written
+     */
+    static void flush();
+
+    static bool is_async() { return async_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Access records are enabled (async mode only)
+     */
+    static bool is_access_log() { return access_log_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Log a served request
+     * @param method Request method
+     * @param path Request target
+     * @param status Response status code
+     * @param bytes Response size
+     * @param duration Time to serve the request
+     */
+    static void access(std::string_view method, std::string_view path, int status, std::size_t bytes,
+        std::chrono::microseconds duration);
+
     /**
      * @brief Log a debug message
      * @param format Format string (fmt style)
@@ -88,6 +185,19 @@ namespace utils
 
   private:
     static LogLevel min_level_;
+    static std::atomic<bool> async_;
+    static std::atomic<bool> access_log_;
+
+    /**
+     * @brief Free slot in the ring of the calling thread with time and level
+     * set, nullptr when the record is dropped
+     */
+    static LogRecord *acquire(LogLevel level, LogRecord::Kind kind);
+
+    /**
+     * @brief Hand the acquired record to the writer
+     */
+    static void commit();
 
     /**
      * @brief Internal logging function
@@ -103,6 +213,21 @@ namespace utils
         return;
       }
 
+      if (is_async())
+      {
+        auto *record = acquire(level, LogRecord::Kind::MESSAGE);
+        if (!record)
+        {
+          return;
+        }
+
+        const auto result = fmt::format_to_n(record->text, LogRecord::TEXT_SIZE, format, std::forward<Args>(args)...);
+        record->size = std::min(result.size, LogRecord::TEXT_SIZE);
+        record->truncated = result.size > LogRecord::TEXT_SIZE;
+        commit();
+        return;
+      }
+
       auto now = std::chrono::system_clock::now();
       auto message = fmt::format(format, std::forward<Args>(args)...);
 
@@ -114,13 +239,28 @@ namespace utils
     }
 
     /**
-     * @brief Get formatted timestamp string
+     * @brief Get formatted timestamp string with nanoseconds, the date and
+     *        time of day are formatted once per second
      * @param time_point Time point to format
-     * @return Formatted timestamp string
+     * @return Formatted timestamp string, valid until the next call
      */
-    static std::string get_timestamp(const std::chrono::system_clock::time_point &time_point)
+    static const std::string &get_timestamp(const std::chrono::system_clock::time_point &time_point)
     {
-      return fmt::format("[{}]", fmt::format("{:%Y-%m-%d %H:%M:%S}", time_point));
+      thread_local std::chrono::sys_seconds second{};
+      thread_local std::string cached;
+      thread_local std::size_t prefix = 0;
+
+      const auto now = std::chrono::floor<std::chrono::seconds>(time_point);
+      if (now != second || cached.empty())
+      {
+        second = now;
+        cached = fmt::format("[{:%Y-%m-%d %H:%M:%S}", now);
+        prefix = cached.size();
+      }
+      const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time_point - now).count();
+      cached.resize(prefix);
+      fmt::format_to(std::back_inserter(cached), ".{:09}]", ns);
+      return cached;
     }
 
     /**
@@ -128,17 +268,25 @@ namespace utils
      * @param level Log level
      * @return Formatted and colored level string
      */
-    static std::string get_level_string(LogLevel level)
+    static std::string_view get_level_string(LogLevel level)
     {
-      switch (level)
+      // colored once, ANSI sequences do not change
+      static const std::string levels[] = {
+          fmt::format(fmt::fg(fmt::color::cyan), "[DEBUG]"),
+          fmt::format(fmt::fg(fmt::color::green), "[INFO ]"),
+          fmt::format(fmt::fg(fmt::color::yellow), "[WARN ]"),
+          fmt::format(fmt::fg(fmt::color::red), "[ERROR]"),
+      };
+
+      const auto i = static_cast<int>(level);
+      if (i < 0 || i > static_cast<int>(LogLevel::ERROR))
       {
-      case LogLevel::DEBUG: return fmt::format(fmt::fg(fmt::color::cyan), "[DEBUG]");
-      case LogLevel::INFO: return fmt::format(fmt::fg(fmt::color::green), "[INFO ]");
-      case LogLevel::WARN: return fmt::format(fmt::fg(fmt::color::yellow), "[WARN ]");
-      case LogLevel::ERROR: return fmt::format(fmt::fg(fmt::color::red), "[ERROR]");
-      default: return "[UNKNOWN]";
+        return "[UNKNOWN]";
       }
+      return levels[i];
     }
+
+    friend class AsyncLogWriter;
   };
 
 } // namespace utils
@@ -0,0 +1,239 @@
+#include "metrics.h++"
+
+#include <fmt/format.h>
+#include <iterator>
+#include <string_view>
+
+namespace utils::metrics
+{
+  namespace
+  {
+    // Prometheus buckets: powers of two from ~1us to ~34s
+    constexpr unsigned LE_FIRST = 10;
+    constexpr unsigned LE_LAST = 35;
+
+    const char *PHASE_NAMES[] = {"accept", "read", "parse", "route", "handler", "serialize", "write"};
+
+    // label value: backslash, quote and newline are escaped
+    auto escape(std::string &out, std::string_view value) -> void
+    {
+      for (const char c : value)
+      {
+        if (c == '\\' || c == '"') out.push_back('\\');
+        if (c == '\n')
+        {
+          out.append("\\n");
+          continue;
+        }
+        out.push_back(c);
+      }
+    }
+  } // namespace
+
+  auto phase_name(const phases phase) -> const char * { return PHASE_NAMES[static_cast<int>(phase)]; }
+
+  auto histogram::merge(const histogram &other) -> void
+  {
+    for (unsigned i = 0; i < BUCKETS; ++i)
+    {
+      bump(counts_[i], other.get_bucket(i));
+    }
+    bump(sum_, other.get_sum());
+    bump(count_, other.get_count());
+  }
+
+  auto histogram::value_at(const double q) const -> uint64_t
+  {
+    const uint64_t total = get_count();
+    if (total == 0) return 0;
+
+    // rank of the value, 1-based
+    uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < BUCKETS; ++i)
+    {
+      seen += get_bucket(i);
+      if (seen >= rank) return upper_bound(i);
+    }
+    return upper_bound(BUCKETS - 1);
+  }
+
+  auto histogram::upper_bound(const unsigned i) -> uint64_t
+  {
+    if (i < SUB) return i;
+
+    const unsigned shift = i / SUB - 1;
+    const uint64_t lower = static_cast<uint64_t>(SUB + i % SUB) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+  }
+
+  shard::shard(const std::size_t routes)
+      : routes_(std::make_unique<std::atomic<uint64_t>[]>(routes))
+      , routes_size_(routes)
+  {
+  }
+
+  auto registry::get() -> registry &
+  {
+    static registry instance;
+    return instance;
+  }
+
+  auto registry::set_routes(std::vector<std::string> routes) -> void
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    routes_ = std::move(routes);
+  }
+
+  auto registry::attach() -> shard *
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty())
+    {
+      shards_.push_back(std::make_unique<shard>(routes_.size()));
+      return shards_.back().get();
+    }
+
+    auto *s = free_.back();
+    free_.pop_back();
+    if (s->routes_size_ < routes_.size())
+    {
+      // nobody writes a free shard, readers hold the lock
+      auto routes = std::make_unique<std::atomic<uint64_t>[]>(routes_.size());
+      for (std::size_t i = 0; i < s->routes_size_; ++i)
+      {
+        routes[i].store(s->routes_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      }
+      s->routes_ = std::move(routes);
+      s->routes_size_ = routes_.size();
+    }
+    return s;
+  }
+
+  auto registry::detach(shard *s) -> void
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(s);
+  }
+
+  auto registry::get_size() -> std::size_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shards_.size();
+  }
+
+  auto registry::get_phase(const phases phase, histogram &out) -> void
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &s : shards_)
+    {
+      out.merge(s->phases_[static_cast<int>(phase)]);
+    }
+  }
+
+  auto registry::get_counter(const counters counter) -> int64_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t total = 0;
+    for (const auto &s : shards_)
+    {
+      total += s->counters_[static_cast<int>(counter)].load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  auto registry::get_status(const int code) -> uint64_t
+  {
+    if (code < 0 || code >= shard::STATUSES) return 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t total = 0;
+    for (const auto &s : shards_)
+    {
+      total += s->statuses_[code].load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  auto registry::render(std::string &out) -> void
+  {
+    auto it = std::back_inserter(out);
+    const auto counter = [&](const char *name, const char *type, const char *help, const counters c)
+    {
+      fmt::format_to(it, "# HELP {} {}\n# TYPE {} {}\n{} {}\n", name, help, name, type, name, get_counter(c));
+    };
+
+    counter("srv_connections_accepted_total", "counter", "Accepted connections.", counters::accepted);
+    counter("srv_connections_open", "gauge", "Open connections.", counters::connections);
+    counter("srv_requests_total", "counter", "Served requests, parse errors included.", counters::requests);
+    counter("srv_bytes_received_total", "counter", "Bytes read from peers.", counters::bytes_in);
+    counter("srv_bytes_sent_total", "counter", "Bytes written to peers.", counters::bytes_out);
+
+    out.append("# HELP srv_responses_total Responses by status code.\n# TYPE srv_responses_total counter\n");
+    for (int code = 100; code < shard::STATUSES; ++code)
+    {
+      const auto count = get_status(code);
+      if (count) fmt::format_to(it, "srv_responses_total{{code=\"{}\"}} {}\n", code, count);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      out.append("# HELP srv_route_requests_total Requests matched by route.\n");
+      out.append("# TYPE srv_route_requests_total counter\n");
+      // routes with the same url and other methods share the label
+      std::vector<bool> done(routes_.size());
+      for (std::size_t i = 0; i < routes_.size(); ++i)
+      {
+        if (done[i]) continue;
+
+        uint64_t count = 0;
+        for (std::size_t j = i; j < routes_.size(); ++j)
+        {
+          if (routes_[j] != routes_[i]) continue;
+          done[j] = true;
+          for (const auto &s : shards_)
+          {
+            if (j < s->routes_size_) count += s->routes_[j].load(std::memory_order_relaxed);
+          }
+        }
+        out.append("srv_route_requests_total{route=\"");
+        escape(out, routes_[i]);
+        fmt::format_to(it, "\"}} {}\n", count);
+      }
+    }
+
+    out.append("# HELP srv_phase_duration_seconds Time spent in request phases.\n");
+    out.append("# TYPE srv_phase_duration_seconds histogram\n");
+    for (int p = 0; p < static_cast<int>(phases::count); ++p)
+    {
+      histogram h;
+      get_phase(static_cast<phases>(p), h);
+      const char *name = PHASE_NAMES[p];
+
+      // octaves start on a bucket, so bucket counts add up exactly
+      uint64_t cumulative = 0;
+      unsigned bucket = 0;
+      for (unsigned e = LE_FIRST; e <= LE_LAST; ++e)
+      {
+        const unsigned end = histogram::index(uint64_t(1) << e);
+        for (; bucket < end; ++bucket)
+        {
+          cumulative += h.get_bucket(bucket);
+        }
+        fmt::format_to(it, "srv_phase_duration_seconds_bucket{{phase=\"{}\",le=\"{:g}\"}} {}\n", name,
+            static_cast<double>(uint64_t(1) << e) / 1e9, cumulative);
+      }
+      // count from the buckets, not torn by a concurrent record
+      for (; bucket < histogram::BUCKETS; ++bucket)
+      {
+        cumulative += h.get_bucket(bucket);
+      }
+      fmt::format_to(it, "srv_phase_duration_seconds_bucket{{phase=\"{}\",le=\"+Inf\"}} {}\n", name, cumulative);
+      fmt::format_to(it, "srv_phase_duration_seconds_sum{{phase=\"{}\"}} {:g}\n", name, h.get_sum() / 1e9);
+      fmt::format_to(it, "srv_phase_duration_seconds_count{{phase=\"{}\"}} {}\n", name, cumulative);
+    }
+  }
+} // namespace utils::metrics
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils::metrics
+{
+  /**
+   * @brief      Timed phases of a request
+   */
+  enum class phases : uint8_t
+  {
+    accept,
+    read,
+    parse,
+    route,
+    handler,
+    serialize,
+    write,
+    count
+  };
+
+  enum class counters : uint8_t
+  {
+    accepted,
+    connections, // gauge, open connections
+    requests,
+    bytes_in,
+    bytes_out,
+    count
+  };
+
+  /**
+   * @brief      Log-linear latency histogram in nanoseconds.
+   *
+   * @details    Every power of two is split into SUB buckets, so a recorded
+   *             value is off by at most 1/SUB (12.5%) at any magnitude, like
+   *             HdrHistogram with one significant digit. Written by the owner
+   *             thread only: relaxed load and store, no locked instruction.
+   */
+  class histogram
+  {
+  public:
+    constexpr static unsigned SUB_BITS = 3;
+    constexpr static unsigned SUB = 1u << SUB_BITS;
+    constexpr static unsigned BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    auto record(const uint64_t ns) -> void
+    {
+      bump(counts_[index(ns)], 1);
+      bump(sum_, ns);
+      bump(count_, 1);
+    }
+
+    /**
+     * @brief      Add other histogram (concurrent reads are approximate)
+     */
+    auto merge(const histogram &other) -> void;
+
+    /**
+     * @brief      Value at quantile q (0..1), upper bound of its bucket
+     */
+    auto value_at(const double q) const -> uint64_t;
+
+    auto get_count() const -> uint64_t { return count_.load(std::memory_order_relaxed); }
+
+    auto get_sum() const -> uint64_t { return sum_.load(std::memory_order_relaxed); }
+
+    auto get_bucket(const unsigned i) const -> uint64_t { return counts_[i].load(std::memory_order_relaxed); }
+
+    static auto index(const uint64_t ns) -> unsigned
+    {
+      if (ns < SUB) return ns;
+
+      const unsigned e = 63 - __builtin_clzll(ns);
+      return (e - SUB_BITS + 1) * SUB + ((ns >> (e - SUB_BITS)) & (SUB - 1));
+    }
+
+    /**
+     * @brief      Largest value of the bucket
+     */
+    static auto upper_bound(const unsigned i) -> uint64_t;
+
+  private:
+    static auto bump(std::atomic<uint64_t> &a, const uint64_t n) -> void
+    {
+      a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> count_{0};
+  };
+
+  /**
+   * @brief      Metrics of one thread, written by that thread only
+   */
+  class alignas(64) shard
+  {
+  public:
+    constexpr static int STATUSES = 600;
+
+    explicit shard(const std::size_t routes);
+
+    auto time(const phases phase, const uint64_t ns) -> void { phases_[static_cast<int>(phase)].record(ns); }
+
+    auto add(const counters counter, const int64_t n) -> void
+    {
+      auto &c = counters_[static_cast<int>(counter)];
+      c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    auto status(const int code) -> void
+    {
+      if (code < 0 || code >= STATUSES) return;
+      auto &c = statuses_[code];
+      c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief      Count request of the route (index of router::add order).
+     *             Routes added after the shard was created are not counted.
+     */
+    auto route(const uint32_t index) -> void
+    {
+      if (index >= routes_size_) return;
+      auto &c = routes_[index];
+      c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+  private:
+    friend class registry;
+
+    std::array<histogram, static_cast<int>(phases::count)> phases_;
+    std::array<std::atomic<int64_t>, static_cast<int>(counters::count)> counters_{};
+    std::array<std::atomic<uint64_t>, STATUSES> statuses_{};
+    std::unique_ptr<std::atomic<uint64_t>[]> routes_;
+    std::size_t routes_size_;
+  };
+
+  /**
+   * @brief      Process wide list of shards.
+   *
+   * @details    Every thread gets its own shard on the first probe. A
+   *             finished thread hands its shard back and the next thread
+   *             continues it, so counters of finished threads are kept and
+   *             short-lived threads do not grow the list. Reading merges all
+   *             shards and is the only locked path.
+   */
+  class registry
+  {
+  public:
+    static auto get() -> registry &;
+
+    /**
+     * @brief      Set route labels, index is the route order. Call before
+     *             the threads that serve requests are started.
+     */
+    auto set_routes(std::vector<std::string> routes) -> void;
+
+    /**
+     * @brief      Shard of the calling thread, reused from a finished thread
+     *             when one is free
+     */
+    auto attach() -> shard *;
+
+    /**
+     * @brief      Give back shard of a finishing thread
+     */
+    auto detach(shard *s) -> void;
+
+    /**
+     * @brief      Number of shards, attached or free
+     */
+    auto get_size() -> std::size_t;
+
+    /**
+     * @brief      Merge phase histograms of all threads into out
+     */
+    auto get_phase(const phases phase, histogram &out) -> void;
+
+    auto get_counter(const counters counter) -> int64_t;
+
+    auto get_status(const int code) -> uint64_t;
+
+    /**
+     * @brief      Append all metrics in Prometheus text format 0.0.4
+     */
+    auto render(std::string &out) -> void;
+
+  private:
+    std::mutex mutex_;
+    std::vector<std::string> routes_;
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::vector<shard *> free_;
+  };
+
+  /**
+   * @brief      Shard of the calling thread
+   */
+  inline auto local() -> shard &
+  {
+    struct holder
+    {
+      shard *s = registry::get().attach();
+      ~holder() { registry::get().detach(s); }
+    };
+    thread_local holder h;
+    return *h.s;
+  }
+
+  /**
+   * @brief      Record time of the scope
+   */
+  class timer
+  {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    explicit timer(const phases phase)
+        : phase_(phase)
+        , start_(clock::now())
+    {
+    }
+
+    ~timer()
+    {
+      const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count();
+      local().time(phase_, ns);
+    }
+
+    timer(const timer &) = delete;
+    auto operator=(const timer &) -> timer & = delete;
+
+  private:
+    phases phase_;
+    clock::time_point start_;
+  };
+
+  template<typename F>
+  inline auto timed(const phases phase, F &&f) -> decltype(f())
+  {
+    timer t(phase);
+    return f();
+  }
+
+  auto phase_name(const phases phase) -> const char *;
+} // namespace utils::metrics
+
+// Probes, empty unless built with SRV_METRICS. Arguments of disabled probes
+// are not evaluated, except the expression of METRICS_TIMED.
+#if defined(SRV_METRICS)
+#define METRICS_CONCAT_(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_(a, b)
+#define METRICS_TIME(phase) \
+  const utils::metrics::timer METRICS_CONCAT(metrics_timer_, __LINE__)(utils::metrics::phases::phase)
+#define METRICS_TIMED(phase, expr) utils::metrics::timed(utils::metrics::phases::phase, [&]() { return expr; })
+#define METRICS_ADD(counter, n) utils::metrics::local().add(utils::metrics::counters::counter, (n))
+#define METRICS_STATUS(code) utils::metrics::local().status(code)
+#define METRICS_ROUTE(index) utils::metrics::local().route(index)
+#else
+#define METRICS_TIME(phase)
+#define METRICS_TIMED(phase, expr) (expr)
+#define METRICS_ADD(counter, n) ((void)0)
+#define METRICS_STATUS(code) ((void)0)
+#define METRICS_ROUTE(index) ((void)0)
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace utils
+{
+  /**
+   * @brief      Bounded single producer, single consumer ring.
+   *
+   * @details    Slots are filled in place: the producer claims a slot, writes
+   *             it and publishes it, the consumer reads the front slot and
+   *             pops it. Head and tail live on their own cache lines and each
+   *             side caches the other's index, so the shared lines are only
+   *             touched when the cached view says full or empty.
+   */
+  template<typename T>
+  class spsc_ring
+  {
+  public:
+    /**
+     * @param[in]  capacity  Number of slots, rounded up to a power of two
+     */
+    explicit spsc_ring(const std::size_t capacity);
+
+    /**
+     * @brief      Producer: free slot to fill, nullptr when the ring is full
+     */
+    auto claim() -> T *;
+
+    /**
+     * @brief      Producer: make the claimed slot visible to the consumer
+     */
+    auto publish() -> void;
+
+    /**
+     * @brief      Consumer: oldest published slot, nullptr when empty
+     */
+    auto front() -> T *;
+
+    /**
+     * @brief      Consumer: release the front slot
+     */
+    auto pop() -> void;
+
+    auto capacity() -> std::size_t { return slots_.size(); }
+
+    auto size() -> std::size_t
+    {
+      return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+  private:
+    static auto round_up(const std::size_t n) -> std::size_t;
+
+    std::vector<T> slots_;
+    std::size_t mask_;
+
+    alignas(64) std::atomic<std::size_t> head_; // consumer
+    std::size_t cached_tail_;
+
+    alignas(64) std::atomic<std::size_t> tail_; // producer
+    std::size_t cached_head_;
+  };
+
+  template<typename T>
+  spsc_ring<T>::spsc_ring(const std::size_t capacity)
+      : slots_(round_up(capacity))
+      , mask_(slots_.size() - 1)
+      , head_(0)
+      , cached_tail_(0)
+      , tail_(0)
+      , cached_head_(0)
+  {
+  }
+
+  template<typename T>
+  auto spsc_ring<T>::claim() -> T *
+  {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size())
+    {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == slots_.size()) return nullptr;
+    }
+    return &slots_[tail & mask_];
+  }
+
+  template<typename T>
+  auto spsc_ring<T>::publish() -> void
+  {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  template<typename T>
+  auto spsc_ring<T>::front() -> T *
+  {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_)
+    {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) return nullptr;
+    }
+    return &slots_[head & mask_];
+  }
+
+  template<typename T>
+  auto spsc_ring<T>::pop() -> void
+  {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  template<typename T>
+  auto spsc_ring<T>::round_up(const std::size_t n) -> std::size_t
+  {
+    std::size_t size = 1;
+    while (size < n)
+    {
+      size <<= 1;
+    }
+    return size;
+  }
+} // namespace utils
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace utils
+{
+  /**
+   * @brief      Hashed timing wheel.
+   *
+   * @details    Entries are bucketed by the tick they expire on, advancing the
+   *             wheel fires every entry of elapsed slots. There is no cancel:
+   *             the owner checks a fired entry and drops or reschedules it,
+   *             so refreshing a timer is just updating a deadline.
+   */
+  template<typename T>
+  class timer_wheel
+  {
+  public:
+    using clock = std::chrono::steady_clock;
+    using duration = std::chrono::milliseconds;
+
+  public:
+    explicit timer_wheel(const duration tick = duration(250), const std::size_t slots = 64);
+
+    /**
+     * @brief      Fire item after delay (rounded up to the tick)
+     *
+     * @param[in]  item   The item
+     * @param[in]  delay  The delay
+     *
+     * @return     void
+     */
+    auto schedule(const T &item, const duration delay) -> void;
+
+    /**
+     * @brief      Move wheel to the time point, call expired(item) for every
+     *             fired entry. Callback is allowed to schedule again.
+     *
+     * @param[in]  now      Current time
+     * @param      expired  The callback
+     *
+     * @return     void
+     */
+    template<typename F>
+    auto advance(const clock::time_point now, F &&expired) -> void;
+
+    auto get_tick() -> duration { return tick_; }
+
+    auto size() -> std::size_t { return size_; }
+
+  private:
+    struct entry
+    {
+      T item;
+      std::size_t rounds;
+    };
+
+    duration tick_;
+    std::vector<std::vector<entry>> slots_;
+    std::vector<entry> fired_;
+    std::size_t current_;
+    clock::time_point last_;
+    std::size_t size_;
+  };
+
+  template<typename T>
+  timer_wheel<T>::timer_wheel(const duration tick, const std::size_t slots)
+      : tick_(tick.count() > 0 ? tick : duration(1))
+      , slots_(slots > 0 ? slots : 1)
+      , fired_()
+      , current_(0)
+      , last_(clock::now())
+      , size_(0)
+  {
+  }
+
+  template<typename T>
+  auto timer_wheel<T>::schedule(const T &item, const duration delay) -> void
+  {
+    const std::size_t n = slots_.size();
+    const auto count = (delay.count() + tick_.count() - 1) / tick_.count();
+    const std::size_t ticks = count > 0 ? count : 1;
+
+    slots_[(current_ + ticks) % n].push_back({item, (ticks - 1) / n});
+    ++size_;
+  }
+
+  template<typename T>
+  template<typename F>
+  auto timer_wheel<T>::advance(const clock::time_point now, F &&expired) -> void
+  {
+    while (now - last_ >= tick_)
+    {
+      last_ += tick_;
+      current_ = (current_ + 1) % slots_.size();
+
+      fired_.clear();
+      fired_.swap(slots_[current_]);
+      for (auto &e : fired_)
+      {
+        if (e.rounds > 0)
+        {
+          --e.rounds;
+          slots_[current_].push_back(e);
+          continue;
+        }
+
+        --size_;
+        expired(e.item);
+      }
+    }
+  }
+} // namespace utils
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstring>
+#include <http/connection.h++>
+#include <string>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::http::connection
+{
+  using conn = ::http::connection;
+
+  auto feed(conn &c, const char *data) -> void
+  {
+    c.feed(data, std::strlen(data));
+  }
+
+  TEST_CASE(partial, {
+    conn c{0, 0};
+    feed(c, "GET / HTTP/1.1\r\nHo");
+    ASSERT_TRUE(c.next_request().empty(), "head not complete");
+    feed(c, "st: localhost\r\n");
+    ASSERT_TRUE(c.next_request().empty(), "head still not complete");
+    feed(c, "\r\n");
+    const std::string r(c.next_request());
+    ASSERT_EQ_CHAR(r.c_str(), "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n", "request complete");
+    ASSERT_TRUE(c.get_state() == conn::states::ready, "ready");
+  });
+
+  TEST_CASE(body, {
+    conn c{0, 0};
+    feed(c, "POST / HTTP/1.1\r\ncontent-length: 4\r\n\r\nbo");
+    ASSERT_TRUE(c.next_request().empty(), "body not complete");
+    feed(c, "dy");
+    const auto r = c.next_request();
+    ASSERT_EQ_INT(r.size(), 42, "request with body");
+    ASSERT_TRUE(r.substr(r.size() - 4) == "body", "body bytes");
+  });
+
+  TEST_CASE(binary_body, {
+    conn c{0, 0};
+    const char req[] = "POST / HTTP/1.1\r\nContent-Length: 3\r\n\r\na\0b";
+    c.feed(req, sizeof(req) - 1);
+    const auto r = c.next_request();
+    ASSERT_EQ_INT(r.size(), sizeof(req) - 1, "nul byte in body");
+  });
+
+  TEST_CASE(pipelining, {
+    conn c{0, 0};
+    feed(c, "GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\nGET /3 HTTP/1.1\r\n");
+    ASSERT_TRUE(c.next_request().substr(0, 6) == "GET /1", "first");
+    c.consume();
+    ASSERT_TRUE(c.next_request().substr(0, 6) == "GET /2", "second");
+    c.consume();
+    ASSERT_TRUE(c.next_request().empty(), "third not complete");
+    feed(c, "\r\n");
+    ASSERT_TRUE(c.next_request().substr(0, 6) == "GET /3", "third");
+  });
+
+  TEST_CASE(keep_alive, {
+    conn c11{0, 0};
+    feed(c11, "GET / HTTP/1.1\r\n\r\n");
+    c11.next_request();
+    ASSERT_TRUE(c11.is_keep_alive(), "HTTP/1.1 default");
+
+    conn c10{0, 0};
+    feed(c10, "GET / HTTP/1.0\r\n\r\n");
+    c10.next_request();
+    ASSERT_FALSE(c10.is_keep_alive(), "HTTP/1.0 default");
+
+    conn c10_ka{0, 0};
+    feed(c10_ka, "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n");
+    c10_ka.next_request();
+    ASSERT_TRUE(c10_ka.is_keep_alive(), "HTTP/1.0 keep-alive");
+
+    conn c_close{0, 0};
+    feed(c_close, "GET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+    c_close.next_request();
+    ASSERT_FALSE(c_close.is_keep_alive(), "close");
+  });
+
+  TEST_CASE(errors, {
+    conn bad_len{0, 0};
+    feed(bad_len, "POST / HTTP/1.1\r\nContent-Length: abc\r\n\r\n");
+    bad_len.next_request();
+    ASSERT_EQ_INT(bad_len.get_error(), 400, "bad content length");
+
+    conn chunked{0, 0};
+    feed(chunked, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+    chunked.next_request();
+    ASSERT_EQ_INT(chunked.get_error(), 501, "chunked");
+
+    conn brew{0, 0};
+    feed(brew, "BREW / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    brew.next_request();
+    ASSERT_EQ_INT(brew.get_error(), 501, "unknown method");
+
+    conn big{0, 0};
+    const std::string head(conn::HEADER_LIMIT + 1, 'a');
+    big.feed(head.data(), head.size());
+    big.next_request();
+    ASSERT_EQ_INT(big.get_error(), 431, "head limit");
+  });
+
+  TEST_CASE(input_limit, {
+    conn c{0, 0};
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string batch;
+    while (batch.size() < 64 * 1024)
+      batch += request;
+
+    // the first request is answered, the rest is never consumed
+    ASSERT_TRUE(c.feed(batch.data(), batch.size()), "first batch");
+    ASSERT_TRUE(!c.next_request().empty(), "first request");
+
+    std::size_t fed = batch.size();
+    while (c.feed(batch.data(), batch.size()))
+      fed += batch.size();
+    ASSERT_TRUE(fed > conn::INPUT_LIMIT, "limit reached");
+    ASSERT_TRUE(fed <= conn::INPUT_LIMIT + batch.size(), "input bounded");
+  });
+
+  auto run() -> void
+  {
+    partial();
+    body();
+    binary_body();
+    pipelining();
+    keep_alive();
+    errors();
+    input_limit();
+  }
+} // namespace tests::http::connection
@@ -11,7 +11,7 @@ namespace tests::http::request
   TEST_CASE(parse, {
     const auto request = new ::http::request();
     auto result = request->parse("GET / HTTP/2");
-    ASSERT_EQ_CHAR("/", result->uri.c_str(), "uri");
+    ASSERT_EQ_CHAR("/", std::string(result->uri).c_str(), "uri");
     ASSERT_EQ_FLOAT(2, result->http_ver, "version");
     ASSERT_TRUE(result->method == ::http::request::methods::Get, "method");
     delete request;
@@ -57,6 +57,12 @@ namespace tests::http::request
 
     auto trace = ::http::request::get_method("trace");
     ASSERT_TRUE(trace == ::http::request::methods::Trace, "trace");
+
+    auto head = ::http::request::get_method("HEAD");
+    ASSERT_TRUE(head == ::http::request::methods::Get, "HEAD as GET");
+
+    auto brew = ::http::request::find_method("BREW");
+    ASSERT_TRUE(brew == ::http::request::methods::Unknown, "unknown method");
   })
 
   TEST_CASE(parse_version, {
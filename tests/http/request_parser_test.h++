@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstring>
+#include <http/request.h++>
+#include <http/request_parser.h++>
+#include <string>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::http::request_parser
+{
+  using parser = ::http::request_parser;
+  using result = parser::result;
+  using id = ::http::header_id;
+
+  const char req[] = "POST /api/items?id=1 HTTP/1.1\r\n"
+                     "Host: localhost\r\n"
+                     "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/114.0\r\n"
+                     "content-length: 4\r\n"
+                     "X-Key:  test \r\n\r\n"
+                     "body";
+
+  auto eq(std::string_view actual, const char *expected, const char *message) -> void
+  {
+    ASSERT_EQ_CHAR(std::string(actual).c_str(), expected, message);
+  }
+
+  TEST_CASE(complete, {
+    parser p;
+    ASSERT_TRUE(p.parse(req, sizeof(req) - 1) == result::complete, "complete");
+    eq(p.get_method(), "POST", "method");
+    eq(p.get_uri(), "/api/items?id=1", "uri");
+    eq(p.get_version(), "HTTP/1.1", "version");
+    ASSERT_EQ_INT(p.get_headers_size(), 4, "headers size");
+    eq(p.get_header(id::host), "localhost", "host by id");
+    eq(p.get_header("HOST"), "localhost", "host by name");
+    eq(p.get_header("x-key"), "test", "unknown header trimmed");
+    ASSERT_EQ_INT(p.get_content_length(), 4, "content length");
+    eq(p.get_body(), "body", "body");
+    ASSERT_TRUE(p.get_header(id::cookie).empty(), "missing header");
+    ASSERT_TRUE(p.is_keep_alive(), "keep alive");
+  });
+
+  TEST_CASE(resume, {
+    // feed request byte by byte through a moving buffer
+    parser p;
+    std::string buf;
+    const std::size_t head = std::strlen(req) - 4;
+    for (std::size_t i = 0; i < head - 1; ++i)
+    {
+      buf.push_back(req[i]);
+      buf.shrink_to_fit();
+      if (p.parse(buf.data(), buf.size()) != result::partial)
+      {
+        ASSERT_TRUE(false, "partial head");
+      }
+    }
+    buf.push_back(req[head - 1]);
+    ASSERT_TRUE(p.parse(buf.data(), buf.size()) == result::complete, "completed after split reads");
+    eq(p.get_header(id::user_agent), "Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/114.0", "ua");
+    ASSERT_EQ_INT(p.get_head_size(), head, "head size");
+  });
+
+  TEST_CASE(invalid, {
+    const char lf[] = "GET / HTTP/1.1\nHost: localhost\n\n";
+    parser p1;
+    ASSERT_TRUE(p1.parse(lf, sizeof(lf) - 1) == result::error, "bare lf");
+
+    const char line[] = "GET / invalid request\r\n\r\n";
+    parser p2;
+    ASSERT_TRUE(p2.parse(line, sizeof(line) - 1) == result::error, "bad request line");
+    ASSERT_EQ_INT(p2.get_error(), 400, "bad request code");
+
+    const char colon[] = "GET / HTTP/1.1\r\nno colon\r\n\r\n";
+    parser p3;
+    ASSERT_TRUE(p3.parse(colon, sizeof(colon) - 1) == result::error, "header without colon");
+  });
+
+  TEST_CASE(smuggling, {
+    const char same[] = "POST / HTTP/1.1\r\nContent-Length: 4\r\nContent-Length: 4\r\n\r\nbody";
+    parser p1;
+    ASSERT_TRUE(p1.parse(same, sizeof(same) - 1) == result::complete, "repeated content length");
+    ASSERT_EQ_INT(p1.get_content_length(), 4, "same value");
+
+    const char conflict[] = "POST / HTTP/1.1\r\nContent-Length: 4\r\ncontent-length: 0\r\n\r\nbody";
+    parser p2;
+    ASSERT_TRUE(p2.parse(conflict, sizeof(conflict) - 1) == result::error, "conflicting content length");
+    ASSERT_EQ_INT(p2.get_error(), 400, "conflict code");
+
+    const char space[] = "POST / HTTP/1.1\r\nContent-Length : 4\r\n\r\nbody";
+    parser p3;
+    ASSERT_TRUE(p3.parse(space, sizeof(space) - 1) == result::error, "space before colon");
+    ASSERT_EQ_INT(p3.get_error(), 400, "space code");
+
+    const char tab[] = "GET / HTTP/1.1\r\nHost\t: localhost\r\n\r\n";
+    parser p4;
+    ASSERT_TRUE(p4.parse(tab, sizeof(tab) - 1) == result::error, "tab before colon");
+
+    const char gzip[] = "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n";
+    parser p5;
+    ASSERT_TRUE(p5.parse(gzip, sizeof(gzip) - 1) == result::error, "unknown transfer coding");
+    ASSERT_EQ_INT(p5.get_error(), 400, "unknown transfer coding code");
+
+    const char gzip_cl[] = "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\nContent-Length: 4\r\n\r\nbody";
+    parser p6;
+    ASSERT_TRUE(p6.parse(gzip_cl, sizeof(gzip_cl) - 1) == result::error, "transfer coding and content length");
+    ASSERT_EQ_INT(p6.get_error(), 400, "transfer coding and content length code");
+
+    const char cl_chunked[] = "POST / HTTP/1.1\r\nContent-Length: 4\r\nTransfer-Encoding: chunked\r\n\r\nbody";
+    parser p7;
+    ASSERT_TRUE(p7.parse(cl_chunked, sizeof(cl_chunked) - 1) == result::error, "content length and chunked");
+    ASSERT_EQ_INT(p7.get_error(), 400, "content length and chunked code");
+
+    const char chunked[] = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    parser p8;
+    ASSERT_TRUE(p8.parse(chunked, sizeof(chunked) - 1) == result::error, "chunked");
+    ASSERT_EQ_INT(p8.get_error(), 501, "chunked is not implemented");
+  });
+
+  TEST_CASE(find_char, {
+    const std::string s = std::string(70, 'a') + ":" + std::string(10, 'b');
+    const auto found = parser::find_char(s.data(), s.data() + s.size(), ':');
+    ASSERT_EQ_INT(found - s.data(), 70, "vector path");
+    const auto short_found = parser::find_char(s.data() + 65, s.data() + 75, ':');
+    ASSERT_EQ_INT(short_found - s.data(), 70, "scalar tail");
+    const auto missing = parser::find_char(s.data(), s.data() + s.size(), '\n');
+    ASSERT_TRUE(missing == s.data() + s.size(), "not found");
+  });
+
+  TEST_CASE(to_request, {
+    parser p;
+    p.parse(req, sizeof(req) - 1);
+    ::http::request r;
+    const auto parsed = r.parse(p);
+    ASSERT_TRUE(parsed != nullptr, "valid");
+    ASSERT_TRUE(parsed->method == ::http::request::methods::Post, "method");
+    eq(parsed->uri, "/api/items?id=1", "uri");
+    ASSERT_TRUE(parsed->uri.data() == p.get_uri().data(), "uri not copied");
+    ASSERT_EQ_FLOAT(parsed->http_ver, 1.1, "version");
+    eq(r.get_header(id::host), "localhost", "header");
+    eq(r.get_body(), "body", "body");
+  });
+
+  auto run() -> void
+  {
+    complete();
+    resume();
+    invalid();
+    smuggling();
+    find_char();
+    to_request();
+  }
+} // namespace tests::http::request_parser
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <cstring>
 #include <http/response.h++>
+#include <string>
 
 #undef TEST_EXIT_ONFAIL
 #define TEST_EXIT_ONFAIL 1
@@ -81,6 +82,49 @@ namespace tests::http::response
     ASSERT_EQ_CHAR(res.get_body().data(), "body_string", "body string");
   });
 
+  TEST_CASE(serialize, {
+    ::http::response res{404, "Not Found"};
+    res.with_raw_header("Server: Test\r\n");
+    res.with_added_header("Content-Type", "text/plain");
+    res.with_added_header("Content-Length", "100");
+    res.with_body("missing");
+
+    std::string head;
+    res.serialize(head);
+    ASSERT_EQ_CHAR(head.c_str(),
+        "HTTP/1.1 404 Not Found\r\nServer: Test\r\nContent-Type: text/plain\r\nContent-Length: 7\r\n\r\n",
+        "head");
+    ASSERT_TRUE(res.get_body_view() == "missing", "body is not copied to head");
+
+    ASSERT_EQ_CHAR(res.get_message(), (head + "missing").c_str(), "message");
+    ASSERT_EQ_CHAR(res.get_message(), (head + "missing").c_str(), "message is not growing");
+
+    res.with_status(418, "I'm a teapot");
+    head.clear();
+    res.serialize(head);
+    ASSERT_TRUE(head.starts_with("HTTP/1.1 418 I'm a teapot\r\n"), "custom status line");
+
+    res.with_status(304, "");
+    head.clear();
+    res.serialize(head);
+    ASSERT_TRUE(head.starts_with("HTTP/1.1 304 Not Modified\r\n"), "standard reason");
+    ASSERT_TRUE(head.find("Content-Length") == std::string::npos, "no length for 304");
+  });
+
+  TEST_CASE(reset, {
+    ::http::response res{500, "Internal Server Error"};
+    res.with_added_header("Content-Type", "text/plain");
+    res.with_raw_header("Server: Test\r\n");
+    res.with_body("error");
+    res.reset();
+
+    std::string head;
+    res.serialize(head);
+    ASSERT_EQ_CHAR(head.c_str(), "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", "clean response");
+    ASSERT_EQ_CHAR(::http::response::reason_phrase(431), "Request Header Fields Too Large", "reason phrase");
+    ASSERT_TRUE(::http::response::status_line(599).empty(), "unknown code");
+  });
+
   auto run() -> void
   {
     unique_header();
@@ -91,5 +135,7 @@ namespace tests::http::response
     added_header();
     has_header();
     with_body();
+    serialize();
+    reset();
   }
 } // namespace tests::http::response
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <http/router.h++>
+#include <stdexcept>
+#include <string>
 #undef TEST_EXIT_ONFAIL
 #define TEST_EXIT_ONFAIL 1
 #include "../testSuite.h"
@@ -103,11 +105,124 @@ namespace tests::http::router
     ASSERT_EQ_INT(router.get_size(), 2, "with multiple methods");
   });
 
+  TEST_CASE(typed_params, {
+    ::http::router router;
+    router.add("/users/{id:int}", method::Get,
+        [](request *req, response *res) {
+
+        });
+    router.add("/users/me", method::Get,
+        [](request *req, response *res) {
+
+        });
+    router.add("/tags/{slug}/page/{n:int}", method::Get,
+        [](request *req, response *res) {
+
+        });
+    router.add("/posts/{slug:[a-z-]+}", method::Get,
+        [](request *req, response *res) {
+
+        });
+
+    request::params_map params;
+    const auto user = router.match("/users/42", method::Get, params);
+    ASSERT_TRUE(user && user->url == "/users/{id:int}", "int param matched");
+    ASSERT_EQ_INT(params.size(), 1, "one param");
+    ASSERT_TRUE(params[0] == "42", "param value");
+
+    const auto me = router.match("/users/me", method::Get, params);
+    ASSERT_TRUE(me && me->url == "/users/me", "static segment wins");
+    ASSERT_TRUE(params.empty(), "static segment has no params");
+
+    ASSERT_TRUE(router.match("/users/4x", method::Get, params) == nullptr, "not int");
+    ASSERT_TRUE(params.empty(), "params dropped on miss");
+
+    const auto tag = router.match("/tags/cpp/page/3/", method::Get, params);
+    ASSERT_TRUE(tag != nullptr, "two params, trailing slash");
+    ASSERT_EQ_INT(params.size(), 2, "two params");
+    ASSERT_TRUE(params[0] == "cpp" && params[1] == "3", "params in order");
+
+    ASSERT_TRUE(router.match("/posts/long-slug?page=2", method::Get, params) != nullptr, "query stripped");
+    ASSERT_TRUE(params[0] == "long-slug", "regex param value");
+    ASSERT_TRUE(router.match("/posts/Upper", method::Get, params) == nullptr, "regex not matched");
+  });
+
+  TEST_CASE(match_method, {
+    ::http::router router;
+    router.add("/item", method::Get,
+        [](request *req, response *res) {
+
+        });
+    router.add("/item", {method::Post, method::Put},
+        [](request *req, response *res) {
+
+        });
+
+    request::params_map params;
+    const auto get = router.match("/item", method::Get, params);
+    const auto put = router.match("/item", method::Put, params);
+    ASSERT_TRUE(get && router.is_method_allowed(get, method::Get), "get route");
+    ASSERT_TRUE(put && router.is_method_allowed(put, method::Put), "put route");
+    ASSERT_TRUE(get != put, "route per methods");
+
+    const auto del = router.match("/item", method::Delete, params);
+    ASSERT_TRUE(del != nullptr, "url matched");
+    ASSERT_FALSE(router.is_method_allowed(del, method::Delete), "method not allowed");
+
+    // a param sibling allows the method the int route does not
+    router.add("/a/{id:int}", method::Get, [](request *, response *) {});
+    router.add("/a/{name}", method::Post, [](request *, response *) {});
+    const auto post = router.match("/a/5", method::Post, params);
+    ASSERT_TRUE(post && post->url == "/a/{name}", "backtracked to sibling");
+    ASSERT_TRUE(params.size() == 1 && params[0] == "5", "sibling param");
+
+    const auto patch = router.match("/a/5", method::Patch, params);
+    ASSERT_TRUE(patch && patch->url == "/a/{id:int}", "first route for 405");
+    ASSERT_FALSE(router.is_method_allowed(patch, method::Patch), "not allowed anywhere");
+  });
+
+  TEST_CASE(params_capacity, {
+    request::params_map params;
+    bool pushed = true;
+    for (std::size_t i = 0; i < request::params_map::CAPACITY; ++i)
+    {
+      pushed = params.push_back("v") && pushed;
+    }
+    ASSERT_TRUE(pushed, "push up to capacity");
+    ASSERT_FALSE(params.push_back("v"), "full");
+    ASSERT_EQ_INT(params.size(), request::params_map::CAPACITY, "size kept");
+
+    std::string url;
+    for (std::size_t i = 0; i < request::params_map::CAPACITY; ++i)
+    {
+      url.append("/{p}");
+    }
+    ::http::router router;
+    router.add(url.c_str(), method::Get, [](request *, response *) {});
+    ASSERT_EQ_INT(router.get_size(), 1, "capacity params");
+
+    url.append("/{p}");
+    bool rejected = false;
+    try
+    {
+      router.add(url.c_str(), method::Get, [](request *, response *) {});
+    }
+    catch (const std::invalid_argument &)
+    {
+      rejected = true;
+    }
+    ASSERT_TRUE(rejected, "too many params");
+    ASSERT_EQ_INT(router.get_size(), 1, "route not added");
+  });
+
   auto run() -> void
   {
     add();
     match();
     unique_endpoint();
     match_params();
+    typed_params();
+    match_method();
+    params_capacity();
   }
 } // namespace tests::http::router
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <http/middlewares/response.h++>
+#include <http/options.h++>
+#include <http/server.h++>
+#include <io/uring/uring.h++>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::http::server
+{
+  constexpr int PORT = 3048;
+
+  // requests over one connection, response bytes until the server closes it
+  auto exchange(const char *requests, const bool half_close = false) -> std::string
+  {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(PORT);
+
+    const int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    timeval timeout{2, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    // fixed window, large responses wait for the reader
+    const int window = 64 * 1024;
+    setsockopt(client, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+    if (::connect(client, (const struct sockaddr *)&addr, sizeof(addr)) == -1)
+    {
+      ::close(client);
+      return {};
+    }
+    ::write(client, requests, std::strlen(requests));
+    if (half_close)
+    {
+      ::shutdown(client, SHUT_WR);
+      // the server sees the end of stream while its output still waits
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::string received;
+    char buf[4096];
+    ssize_t r;
+    while ((r = ::read(client, buf, sizeof(buf))) > 0)
+    {
+      received.append(buf, r);
+    }
+    ::close(client);
+    return received;
+  }
+
+  auto head_then_get(const io::event_loop::backend backend) -> void
+  {
+    auto options = ::http::options({PORT, "127.0.0.1", "Test", "/public", 1, 5, 0, backend});
+    ::http::server app(&options);
+    ::http::middlewares::response response_middleware(&options);
+    app.add_middleware(&response_middleware);
+
+    ::http::router router;
+    router.add("/hello", ::http::request::methods::Get,
+        [](::http::request *, ::http::response *res) { res->with_body("Hello"); });
+    app.with_routers(&router);
+
+    std::thread server([&app]() { app.listen(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    const auto received = exchange("HEAD /hello HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                                   "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    app.shutdown();
+    server.join();
+
+    const auto second = received.find("HTTP/1.1", 1);
+    ASSERT_TRUE(second != std::string::npos, "two responses");
+
+    const auto head = received.substr(0, second);
+    ASSERT_TRUE(head.find("Content-Length: 5\r\n") != std::string::npos, "HEAD keeps Content-Length");
+    ASSERT_TRUE(head.ends_with("\r\n\r\n"), "HEAD without body");
+    ASSERT_TRUE(head.find("Connection: keep-alive") != std::string::npos, "kept alive");
+
+    const auto get = received.substr(second);
+    ASSERT_TRUE(get.starts_with("HTTP/1.1 200"), "GET after HEAD");
+    ASSERT_TRUE(get.ends_with("\r\n\r\nHello"), "GET with body");
+  }
+
+  TEST_CASE(head_keep_alive, {
+    head_then_get(io::event_loop::backend::epoll);
+    if (io::uring::is_supported()) head_then_get(io::event_loop::backend::uring);
+  });
+
+  auto large_after_eof(const io::event_loop::backend backend) -> void
+  {
+    auto options = ::http::options({PORT, "127.0.0.1", "Test", "/public", 1, 5, 0, backend});
+    ::http::server app(&options);
+    ::http::middlewares::response response_middleware(&options);
+    app.add_middleware(&response_middleware);
+
+    // larger than the socket buffer, the response waits for writability
+    const std::string body(8 * 1024 * 1024, 'x');
+    ::http::router router;
+    router.add("/large", ::http::request::methods::Get,
+        [&body](::http::request *, ::http::response *res) { res->with_body(body); });
+    app.with_routers(&router);
+
+    std::thread server([&app]() { app.listen(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto received = exchange("GET /large HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                                   "GET /large HTTP/1.1\r\nHost: localhost\r\n\r\n",
+        true);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    app.shutdown();
+    server.join();
+
+    const auto second = received.find("HTTP/1.1", 1);
+    ASSERT_TRUE(second != std::string::npos, "both requests answered");
+    ASSERT_TRUE(received.ends_with(body), "second response complete");
+    ASSERT_TRUE(received.size() == second * 2, "first response complete");
+    ASSERT_TRUE(elapsed < std::chrono::seconds(1), "closed after the output");
+  }
+
+  TEST_CASE(half_close, {
+    large_after_eof(io::event_loop::backend::epoll);
+    if (io::uring::is_supported()) large_after_eof(io::event_loop::backend::uring);
+  });
+
+  auto run() -> void
+  {
+    head_keep_alive();
+    half_close();
+  }
+} // namespace tests::http::server
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <http/static_files.h++>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::http::static_files
+{
+  using files = ::http::static_files;
+
+  auto make_root() -> std::string
+  {
+    const auto root = std::filesystem::temp_directory_path() / ("static_files_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(root / "css");
+    return root.string();
+  }
+
+  auto put(const std::string &path, const std::string &data) -> void
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << data;
+  }
+
+  // changes are applied by the watcher thread, wait for it up to a second
+  template<typename F>
+  auto eventually(F &&done) -> bool
+  {
+    for (int i = 0; i < 100; ++i)
+    {
+      if (done()) return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  TEST_CASE(find, {
+    const auto root = make_root();
+    put(root + "/index.html", "<html></html>");
+    put(root + "/css/app.css", "body{}");
+
+    files cache(root);
+    const auto file = cache.find("/index.html?v=1");
+    ASSERT_TRUE(file != nullptr, "found");
+    ASSERT_EQ_INT(file->size, 13, "size");
+    ASSERT_TRUE(file->is_in_memory(), "small file is cached in memory");
+    ASSERT_EQ_CHAR(file->content_type, "text/html;charset=utf-8", "content type");
+    ASSERT_EQ_CHAR(file->content_length.c_str(), "13", "content length");
+    ASSERT_TRUE(file->etag.front() == '"' && file->etag.back() == '"', "quoted etag");
+
+    ASSERT_TRUE(cache.find("/index.html") == file, "cache hit");
+    ASSERT_EQ_CHAR(cache.find("/css/app.css")->content_type, "text/css;charset=utf-8", "css");
+    ASSERT_EQ_INT(cache.get_size(), 2, "entries");
+    ASSERT_EQ_INT(cache.get_bytes(), 19, "bytes");
+
+    ASSERT_TRUE(cache.find("/css") == nullptr, "directory");
+    ASSERT_TRUE(cache.find("/missing.js") == nullptr, "missing");
+    ASSERT_TRUE(cache.find("/css/../index.html") == nullptr, "dot-dot");
+
+    ASSERT_TRUE(cache.find("//index.html") != nullptr, "other spelling served");
+    ASSERT_EQ_INT(cache.get_size(), 2, "other spelling not cached");
+
+    std::filesystem::remove_all(root);
+  });
+
+  TEST_CASE(invalidate, {
+    const auto root = make_root();
+    put(root + "/app.js", "let a = 1;");
+
+    files cache(root);
+    const auto before = cache.find("/app.js");
+    ASSERT_EQ_INT(before->size, 10, "original");
+
+    put(root + "/app.js", "let a = 12;");
+    ASSERT_TRUE(eventually([&]() { return cache.find("/app.js") != before; }), "entry replaced");
+    const auto after = cache.find("/app.js");
+    ASSERT_EQ_INT(after->size, 11, "new size");
+    ASSERT_TRUE(after->data == "let a = 12;", "new content");
+    ASSERT_TRUE(before->data == "let a = 1;", "old entry is alive while referenced");
+
+    std::filesystem::remove(root + "/app.js");
+    ASSERT_TRUE(eventually([&]() { return cache.find("/app.js") == nullptr; }), "removed");
+    ASSERT_EQ_INT(cache.get_size(), 0, "no entries");
+
+    std::filesystem::remove_all(root);
+  });
+
+  TEST_CASE(invalidate_directory, {
+    const auto root = make_root();
+    std::filesystem::create_directories(root + "/assets/img");
+    put(root + "/assets/img/logo.svg", "<svg/>");
+    put(root + "/css/app.css", "body{}");
+
+    files cache(root);
+    ASSERT_TRUE(cache.find("/assets/img/logo.svg") != nullptr, "nested file");
+    ASSERT_TRUE(cache.find("/css/app.css") != nullptr, "other directory");
+    ASSERT_EQ_INT(cache.get_size(), 2, "cached");
+
+    // only the parent of the watched directory sees the rename
+    std::filesystem::rename(root + "/assets", root + "/moved");
+    ASSERT_TRUE(eventually([&]() { return cache.find("/assets/img/logo.svg") == nullptr; }), "renamed parent");
+    ASSERT_EQ_INT(cache.get_size(), 1, "other subtree kept");
+    ASSERT_TRUE(cache.find("/moved/img/logo.svg") != nullptr, "served from the new path");
+
+    std::filesystem::remove_all(root + "/moved");
+    ASSERT_TRUE(eventually([&]() { return cache.get_size() == 1; }), "removed subtree");
+    ASSERT_TRUE(cache.find("/moved/img/logo.svg") == nullptr, "removed file");
+
+    std::filesystem::remove_all(root);
+  });
+
+  TEST_CASE(lru, {
+    const auto root = make_root();
+    put(root + "/a.txt", std::string(60, 'a'));
+    put(root + "/b.txt", std::string(60, 'b'));
+
+    files cache(root, 100);
+    cache.find("/a.txt");
+    cache.find("/b.txt");
+    ASSERT_EQ_INT(cache.get_size(), 1, "oldest evicted");
+    ASSERT_EQ_INT(cache.get_bytes(), 60, "bytes limit");
+
+    put(root + "/c.txt", std::string(60, 'c'));
+    files second_chance(root, 130);
+    const auto a = second_chance.find("/a.txt");
+    second_chance.find("/b.txt");
+    ASSERT_TRUE(second_chance.find("/a.txt") == a, "hit");
+    second_chance.find("/c.txt");
+    ASSERT_EQ_INT(second_chance.get_size(), 2, "one evicted");
+    ASSERT_TRUE(second_chance.find("/a.txt") == a, "recently used kept");
+
+    files disabled(root, 0);
+    ASSERT_TRUE(disabled.find("/a.txt") != nullptr, "served without cache");
+    ASSERT_EQ_INT(disabled.get_size(), 0, "nothing cached");
+
+    std::filesystem::remove_all(root);
+  });
+
+  TEST_CASE(conditional, {
+    ::http::static_file file;
+    file.etag = "\"a-1\"";
+    file.mtime = 784111777; // Sun, 06 Nov 1994 08:49:37 GMT
+    file.last_modified = files::format_date(file.mtime);
+    ASSERT_EQ_CHAR(file.last_modified.c_str(), "Sun, 06 Nov 1994 08:49:37 GMT", "date format");
+    ASSERT_TRUE(files::parse_date("Sun, 06 Nov 1994 08:49:37 GMT") == file.mtime, "date parse");
+    ASSERT_TRUE(files::parse_date("yesterday") == -1, "bad date");
+
+    ASSERT_TRUE(files::is_not_modified(file, "\"a-1\"", ""), "etag");
+    ASSERT_TRUE(files::is_not_modified(file, "\"x\", W/\"a-1\"", ""), "etag list, weak");
+    ASSERT_TRUE(files::is_not_modified(file, "*", ""), "any");
+    ASSERT_FALSE(files::is_not_modified(file, "\"b-2\"", file.last_modified), "etag wins over date");
+    ASSERT_TRUE(files::is_not_modified(file, "", "Sun, 06 Nov 1994 08:49:37 GMT"), "same date");
+    ASSERT_FALSE(files::is_not_modified(file, "", "Sat, 05 Nov 1994 08:49:37 GMT"), "older date");
+    ASSERT_FALSE(files::is_not_modified(file, "", ""), "unconditional");
+  });
+
+  TEST_CASE(range, {
+    ::http::static_file file;
+    file.size = 1000;
+    file.etag = "\"a-1\"";
+    off_t offset = 0;
+    std::size_t length = 0;
+    using result = files::range_result;
+
+    ASSERT_TRUE(files::parse_range(file, "bytes=0-99", "", offset, length) == result::partial, "first bytes");
+    ASSERT_TRUE(offset == 0 && length == 100, "0-99");
+    ASSERT_TRUE(files::parse_range(file, "bytes=900-", "", offset, length) == result::partial, "open range");
+    ASSERT_TRUE(offset == 900 && length == 100, "900-");
+    ASSERT_TRUE(files::parse_range(file, "bytes=-10", "", offset, length) == result::partial, "suffix");
+    ASSERT_TRUE(offset == 990 && length == 10, "-10");
+    ASSERT_TRUE(files::parse_range(file, "bytes=500-5000", "", offset, length) == result::partial, "clamped");
+    ASSERT_TRUE(offset == 500 && length == 500, "500-999");
+
+    ASSERT_TRUE(files::parse_range(file, "bytes=1000-", "", offset, length) == result::unsatisfiable, "past end");
+    ASSERT_TRUE(files::parse_range(file, "", "", offset, length) == result::none, "no range");
+    ASSERT_TRUE(offset == 0 && length == 1000, "whole file");
+    ASSERT_TRUE(files::parse_range(file, "bytes=0-1,5-6", "", offset, length) == result::none, "multiple ranges");
+    ASSERT_TRUE(files::parse_range(file, "items=0-1", "", offset, length) == result::none, "unknown unit");
+    ASSERT_TRUE(files::parse_range(file, "bytes=0-9", "\"old\"", offset, length) == result::none, "if-range");
+    ASSERT_TRUE(files::parse_range(file, "bytes=0-9", "\"a-1\"", offset, length) == result::partial, "if-range ok");
+  });
+
+  auto run() -> void
+  {
+    find();
+    invalidate();
+    invalidate_directory();
+    lru();
+    conditional();
+    range();
+  }
+} // namespace tests::http::static_files
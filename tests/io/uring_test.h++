@@ -0,0 +1,118 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <io/uring/uring.h++>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::uring
+{
+  auto make_addr() -> sockaddr_in
+  {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(3047);
+    return addr;
+  }
+
+  auto create_socket() -> int
+  {
+    const auto addr = make_addr();
+    const int socket = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    const int on = 1;
+    setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ::bind(socket, (const struct sockaddr *)&addr, sizeof(addr));
+    ::listen(socket, 100);
+    return socket;
+  }
+
+  auto connect_client() -> int
+  {
+    const auto addr = make_addr();
+    const int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::connect(client, (const struct sockaddr *)&addr, sizeof(addr));
+    return client;
+  }
+
+  TEST_CASE(make, {
+    const auto preferred = io::event_loop::make(io::event_loop::backend::uring);
+    const auto expected = io::uring::is_supported() ? io::event_loop::backend::uring : io::event_loop::backend::epoll;
+    ASSERT_TRUE(preferred->get_backend() == expected, "uring or epoll fallback");
+
+    const auto epoll = io::event_loop::make(io::event_loop::backend::epoll);
+    ASSERT_TRUE(epoll->get_backend() == io::event_loop::backend::epoll, "epoll");
+  });
+
+  TEST_CASE(echo, {
+    if (!io::uring::is_supported()) return;
+
+    const int server = create_socket();
+    io::uring loop;
+    loop.create();
+    loop.register_master(server);
+
+    int peer = -1;
+    std::string received;
+    bool written = false;
+    bool closed = false;
+    loop.on_connection([&](int socket) { peer = socket; });
+    loop.on_data(
+        [&](int socket, const char *data, std::size_t size)
+        {
+          received.append(data, size);
+          if (received != "ping") return;
+
+          char pong[] = "pong";
+          iovec iov{pong, 4};
+          // small write is queued and reported by on_writable
+          ASSERT_TRUE(loop.send(socket, &iov, 1) == io::event_loop::QUEUED, "send queued");
+        });
+    loop.on_writable([&](int) { written = true; });
+    loop.on_close([&](int) { closed = true; });
+
+    const int client = connect_client();
+    ::write(client, "ping", 4);
+    for (int i = 0; i < 10 && !written; ++i)
+    {
+      loop.wait();
+    }
+
+    ASSERT_TRUE(peer > 0, "accepted");
+    ASSERT_EQ_CHAR(received.c_str(), "ping", "received");
+    ASSERT_TRUE(written, "written");
+    ASSERT_EQ_INT(loop.watched_size(), 1, "watched");
+
+    char buf[16] = {};
+    ASSERT_EQ_INT(::read(client, buf, sizeof(buf)), 4, "client read");
+    ASSERT_EQ_CHAR(buf, "pong", "response");
+
+    // linked send and close, peer is not reported closed
+    char bye[] = "bye";
+    iovec iov{bye, 3};
+    ASSERT_TRUE(loop.send_close(peer, &iov, 1), "send and close");
+    ASSERT_EQ_INT(loop.watched_size(), 0, "not watched");
+    loop.wait();
+
+    std::memset(buf, 0, sizeof(buf));
+    ASSERT_EQ_INT(::read(client, buf, sizeof(buf)), 3, "last response");
+    ASSERT_EQ_CHAR(buf, "bye", "last response data");
+    ASSERT_EQ_INT(::read(client, buf, sizeof(buf)), 0, "closed by server");
+    ASSERT_FALSE(closed, "no close callback");
+
+    ::close(client);
+    loop.shutdown();
+  });
+
+  auto run() -> void
+  {
+    make();
+    echo();
+  }
+} // namespace tests::uring
@@ -1,15 +1,23 @@
 #include <chrono>
 
+#include "http/connection_test.h++"
 #include "http/http_parser_test.h++"
 #include "http/http_request_test.h++"
 #include "http/http_uri_test.h++"
+#include "http/request_parser_test.h++"
 #include "http/response_test.h++"
 #include "http/router_test.h++"
+#include "http/server_test.h++"
+#include "http/static_files_test.h++"
 #include "http/stream_test.h++"
 #include "io/epoll_test.h++"
 #include "io/inet_soc_test.h++"
 #include "io/local_soc_test.h++"
+#include "io/uring_test.h++"
 #include "stl/string/ws_string_test.h++"
+#include "utils/logger_test.h++"
+#include "utils/metrics_test.h++"
+#include "utils/timer_wheel_test.h++"
 
 int main()
 {
@@ -18,6 +26,7 @@ int main()
   tests::socket_inet::run();
   tests::socket_local::run();
   tests::epoll::run();
+  tests::uring::run();
   tests::http::run();
   tests::stl::run();
   tests::http::request::run();
@@ -25,6 +34,13 @@ int main()
   tests::http::response::run();
   tests::http::stream::run();
   tests::http::router::run();
+  tests::http::connection::run();
+  tests::http::request_parser::run();
+  tests::http::static_files::run();
+  tests::http::server::run();
+  tests::utils::timer_wheel::run();
+  tests::utils::metrics::run();
+  tests::utils::logger::run();
 
   auto t_end = std::chrono::high_resolution_clock::now();
   double elapsed_time_ms = std::chrono::duration<double, std::milli>(t_end - t_start).count();
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <utils/logger.h++>
+#include <utils/spsc_ring.h++>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::utils::logger
+{
+  using ::utils::Logger;
+
+  const char *LOG_PATH = "/tmp/srv_logger_test.log";
+
+  auto read_file(const std::string &path) -> std::string
+  {
+    std::ifstream file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+  }
+
+  auto remove_logs() -> void
+  {
+    for (const auto &path : {std::string(LOG_PATH), std::string(LOG_PATH) + ".1", std::string(LOG_PATH) + ".2"})
+    {
+      ::unlink(path.c_str());
+    }
+  }
+
+  TEST_CASE(ring, {
+    ::utils::spsc_ring<int> r(3);
+    ASSERT_EQ_INT(r.capacity(), 4, "power of two");
+    ASSERT_TRUE(r.front() == nullptr, "empty");
+
+    for (int round = 0; round < 3; ++round)
+    {
+      for (int i = 0; i < 4; ++i)
+      {
+        auto *slot = r.claim();
+        ASSERT_TRUE(slot != nullptr, "claim");
+        *slot = i;
+        r.publish();
+      }
+      ASSERT_TRUE(r.claim() == nullptr, "full");
+      ASSERT_EQ_INT(r.size(), 4, "size");
+
+      for (int i = 0; i < 4; ++i)
+      {
+        ASSERT_EQ_INT(*r.front(), i, "fifo");
+        r.pop();
+      }
+      ASSERT_TRUE(r.front() == nullptr, "drained");
+    }
+  });
+
+  TEST_CASE(timestamp, {
+    // sync mode prints to stdout, capture it in the log file
+    remove_logs();
+    std::fflush(stdout);
+    const int saved = ::dup(STDOUT_FILENO);
+    const int file = ::open(LOG_PATH, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    ::dup2(file, STDOUT_FILENO);
+    Logger::info("first");
+    Logger::info("second");
+    std::fflush(stdout);
+    ::dup2(saved, STDOUT_FILENO);
+    ::close(saved);
+    ::close(file);
+
+    // [YYYY-MM-DD HH:MM:SS.nnnnnnnnn]
+    const auto log = read_file(LOG_PATH);
+    ASSERT_TRUE(log.starts_with("["), "open");
+    ASSERT_EQ_INT(log.find(']'), 1 + 19 + 10, "nanoseconds");
+    ASSERT_EQ_INT(log[20], '.', "fraction");
+    const auto next = log.find('\n') + 1;
+    ASSERT_EQ_INT(log.find(']', next) - next, 1 + 19 + 10, "cached second");
+    remove_logs();
+  });
+
+  TEST_CASE(console_order, {
+    // stdout and stderr in one file: async records keep their order
+    remove_logs();
+    std::fflush(stdout);
+    std::fflush(stderr);
+    const int saved_out = ::dup(STDOUT_FILENO);
+    const int saved_err = ::dup(STDERR_FILENO);
+    const int file = ::open(LOG_PATH, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    ::dup2(file, STDOUT_FILENO);
+    ::dup2(file, STDERR_FILENO);
+
+    ASSERT_TRUE(Logger::start_async({}), "started");
+    Logger::info("first");
+    Logger::warn("second");
+    Logger::info("third");
+    Logger::stop_async();
+
+    ::dup2(saved_out, STDOUT_FILENO);
+    ::dup2(saved_err, STDERR_FILENO);
+    ::close(saved_out);
+    ::close(saved_err);
+    ::close(file);
+
+    const auto log = read_file(LOG_PATH);
+    const auto first = log.find("first");
+    const auto second = log.find("second");
+    const auto third = log.find("third");
+    ASSERT_TRUE(first != std::string::npos && second != std::string::npos && third != std::string::npos, "all");
+    ASSERT_TRUE(first < second && second < third, "in order");
+    remove_logs();
+  });
+
+  TEST_CASE(json_lines, {
+    remove_logs();
+    ::utils::AsyncOptions options;
+    options.path = LOG_PATH;
+    options.access_log = true;
+    ASSERT_TRUE(Logger::start_async(options), "start");
+    ASSERT_TRUE(Logger::is_async(), "async");
+
+    Logger::info("quoted \"{}\" value={}", "name", 42);
+    Logger::debug("below level");
+    Logger::access("GET", "/users/1", 200, 123, std::chrono::microseconds(45));
+    Logger::flush();
+
+    const auto log = read_file(LOG_PATH);
+    ASSERT_TRUE(log.starts_with("{\"time\":\""), "time");
+    // {"time":"YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ"
+    ASSERT_EQ_INT(log.find('Z'), 9 + 19 + 10, "nanoseconds");
+    ASSERT_TRUE(log.find(R"("level":"info","message":"quoted \"name\" value=42"})") != std::string::npos, "message");
+    ASSERT_TRUE(log.find("below level") == std::string::npos, "level filter");
+    ASSERT_TRUE(log.find(R"("type":"access","method":"GET","path":"/users/1","status":200,"bytes":123,"duration_us":45})") !=
+                    std::string::npos,
+        "access");
+
+    Logger::stop_async();
+    ASSERT_FALSE(Logger::is_async(), "sync");
+    ASSERT_FALSE(Logger::is_access_log(), "access off");
+    remove_logs();
+  });
+
+  TEST_CASE(rotate, {
+    remove_logs();
+    ::utils::AsyncOptions options;
+    options.path = LOG_PATH;
+    options.max_size = 200;
+    options.max_files = 2;
+    ASSERT_TRUE(Logger::start_async(options), "start");
+
+    // two lines fit in a file
+    for (int i = 0; i < 7; ++i)
+    {
+      Logger::warn("rotated message {}", i);
+      Logger::flush();
+    }
+    Logger::stop_async();
+
+    const auto current = read_file(LOG_PATH);
+    const auto previous = read_file(std::string(LOG_PATH) + ".1");
+    const auto oldest = read_file(std::string(LOG_PATH) + ".2");
+    ASSERT_TRUE(current.find("rotated message 6") != std::string::npos, "newest");
+    ASSERT_TRUE(current.size() <= 200, "size limit");
+    ASSERT_FALSE(previous.empty(), "rotated once");
+    ASSERT_FALSE(oldest.empty(), "rotated twice");
+    ASSERT_TRUE((current + previous + oldest).find("rotated message 1") == std::string::npos, "oldest removed");
+    remove_logs();
+  });
+
+  TEST_CASE(drop, {
+    remove_logs();
+    ::utils::AsyncOptions options;
+    options.path = LOG_PATH;
+    options.ring_size = 2;
+    options.flush_interval = std::chrono::milliseconds(1000);
+    ASSERT_TRUE(Logger::start_async(options), "start");
+
+    for (int i = 0; i < 10; ++i)
+    {
+      Logger::info("burst {}", i);
+    }
+    Logger::stop_async();
+
+    const auto log = read_file(LOG_PATH);
+    ASSERT_TRUE(log.find("Log ring is full, dropped ") != std::string::npos, "drops reported");
+    ASSERT_TRUE(log.find("burst 0") != std::string::npos, "first kept");
+    remove_logs();
+  });
+
+  TEST_CASE(block, {
+    remove_logs();
+    ::utils::AsyncOptions options;
+    options.path = LOG_PATH;
+    options.ring_size = 2;
+    options.overflow = ::utils::LogOverflow::BLOCK;
+    ASSERT_TRUE(Logger::start_async(options), "start");
+
+    for (int i = 0; i < 100; ++i)
+    {
+      Logger::info("blocking {}", i);
+    }
+    Logger::stop_async();
+
+    const auto log = read_file(LOG_PATH);
+    ASSERT_TRUE(log.find("dropped") == std::string::npos, "nothing dropped");
+    ASSERT_TRUE(log.find("blocking 99") != std::string::npos, "last kept");
+    remove_logs();
+  });
+
+  auto run() -> void
+  {
+    ring();
+    timestamp();
+    console_order();
+    json_lines();
+    rotate();
+    drop();
+    block();
+  }
+} // namespace tests::utils::logger
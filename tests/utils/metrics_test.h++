@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <utils/metrics.h++>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::utils::metrics
+{
+  namespace m = ::utils::metrics;
+
+  TEST_CASE(buckets, {
+    ASSERT_EQ_INT(m::histogram::index(0), 0, "zero");
+    ASSERT_EQ_INT(m::histogram::index(7), 7, "exact below sub buckets");
+    ASSERT_EQ_INT(m::histogram::index(8), 8, "first octave");
+    ASSERT_EQ_INT(m::histogram::index(16), 16, "second octave");
+    ASSERT_EQ_INT(m::histogram::index(17), 16, "shared bucket");
+    ASSERT_EQ_INT(m::histogram::index(~uint64_t(0)), m::histogram::BUCKETS - 1, "last bucket");
+
+    // every bucket ends right before the next one starts
+    for (unsigned i = 0; i + 1 < m::histogram::BUCKETS; ++i)
+    {
+      const auto upper = m::histogram::upper_bound(i);
+      ASSERT_EQ_INT(m::histogram::index(upper), i, "upper bound in bucket");
+      ASSERT_EQ_INT(m::histogram::index(upper + 1), i + 1, "next bucket");
+    }
+  });
+
+  TEST_CASE(quantiles, {
+    m::histogram h;
+    ASSERT_EQ_INT(h.value_at(0.5), 0, "empty");
+
+    for (uint64_t ns = 1; ns <= 1000; ++ns)
+    {
+      h.record(ns * 1000);
+    }
+    ASSERT_EQ_INT(h.get_count(), 1000, "count");
+    ASSERT_EQ_INT(h.get_sum(), 500500000, "sum");
+
+    // one bucket is 1/8 of its octave wide
+    const auto p50 = h.value_at(0.5);
+    ASSERT_TRUE(p50 >= 500000 && p50 <= 500000 * 9 / 8, "p50");
+    const auto p99 = h.value_at(0.99);
+    ASSERT_TRUE(p99 >= 990000 && p99 <= 990000 * 9 / 8, "p99");
+    ASSERT_TRUE(h.value_at(1) >= 1000000, "max");
+
+    m::histogram merged;
+    merged.merge(h);
+    merged.merge(h);
+    ASSERT_EQ_INT(merged.get_count(), 2000, "merged count");
+    ASSERT_EQ_INT(merged.value_at(0.5), p50, "merged p50");
+  });
+
+  TEST_CASE(render, {
+    auto &registry = m::registry::get();
+    registry.set_routes({"/a", "/b/\\d+", "/a"});
+    const auto sent = registry.get_counter(m::counters::bytes_out);
+    const auto created = registry.get_status(201);
+
+    // shards of other threads are merged
+    std::thread worker(
+        []()
+        {
+          auto &s = m::local();
+          s.add(m::counters::bytes_out, 100);
+          s.status(201);
+          s.route(0);
+          s.route(1);
+          s.route(2);
+          s.route(7); // unknown route is ignored
+          s.time(m::phases::handler, 3000);
+        });
+    worker.join();
+
+    ASSERT_EQ_INT(registry.get_counter(m::counters::bytes_out) - sent, 100, "counter");
+    ASSERT_EQ_INT(registry.get_status(201) - created, 1, "status");
+
+    std::string out;
+    registry.render(out);
+    ASSERT_TRUE(out.find("# TYPE srv_connections_open gauge\n") != std::string::npos, "gauge");
+    ASSERT_TRUE(out.find("srv_responses_total{code=\"201\"}") != std::string::npos, "status line");
+    ASSERT_TRUE(out.find("srv_route_requests_total{route=\"/a\"} 2\n") != std::string::npos, "route shared by url");
+    ASSERT_TRUE(out.find("srv_route_requests_total{route=\"/b/\\\\d+\"} 1\n") != std::string::npos, "escaped route");
+    ASSERT_TRUE(out.find("srv_phase_duration_seconds_bucket{phase=\"handler\",le=\"4.096e-06\"}") !=
+                    std::string::npos,
+        "histogram bucket");
+    ASSERT_TRUE(out.find("srv_phase_duration_seconds_count{phase=\"handler\"}") != std::string::npos, "count");
+
+    registry.set_routes({});
+  });
+
+  TEST_CASE(reuse, {
+    auto &registry = m::registry::get();
+    const auto sent = registry.get_counter(m::counters::bytes_out);
+
+    // one worker at a time, so all of them share a single shard
+    for (int i = 0; i < 16; ++i)
+    {
+      std::thread worker([]() { m::local().add(m::counters::bytes_out, 1); });
+      worker.join();
+    }
+    const auto size = registry.get_size();
+    for (int i = 0; i < 16; ++i)
+    {
+      std::thread worker([]() { m::local().add(m::counters::bytes_out, 1); });
+      worker.join();
+    }
+
+    ASSERT_EQ_INT(registry.get_size(), size, "finished threads give shards back");
+    ASSERT_EQ_INT(registry.get_counter(m::counters::bytes_out) - sent, 32, "counters of finished threads");
+
+    // a reused shard counts routes added after it was created
+    registry.set_routes({"/a", "/b", "/c", "/d"});
+    std::thread worker([]() { m::local().route(3); });
+    worker.join();
+    std::string out;
+    registry.render(out);
+    ASSERT_TRUE(out.find("srv_route_requests_total{route=\"/d\"} 1\n") != std::string::npos, "grown routes");
+    registry.set_routes({});
+  });
+
+  auto run() -> void
+  {
+    buckets();
+    quantiles();
+    render();
+    reuse();
+  }
+} // namespace tests::utils::metrics
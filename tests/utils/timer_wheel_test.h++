@@ -0,0 +1,69 @@
+#pragma once
+
+#include <utils/timer_wheel.h++>
+#include <vector>
+
+#undef TEST_EXIT_ONFAIL
+#define TEST_EXIT_ONFAIL 1
+#include "../testSuite.h"
+
+namespace tests::utils::timer_wheel
+{
+  using wheel = ::utils::timer_wheel<int>;
+  using ms = std::chrono::milliseconds;
+
+  TEST_CASE(fire, {
+    wheel w{ms(100), 8};
+    const auto start = wheel::clock::now();
+    std::vector<int> fired;
+    w.schedule(1, ms(100));
+    w.schedule(2, ms(250));
+    ASSERT_EQ_INT(w.size(), 2, "scheduled");
+
+    w.advance(start + ms(150), [&fired](int id) { fired.push_back(id); });
+    ASSERT_EQ_INT(fired.size(), 1, "first fired");
+    ASSERT_EQ_INT(fired.at(0), 1, "first id");
+
+    w.advance(start + ms(350), [&fired](int id) { fired.push_back(id); });
+    ASSERT_EQ_INT(fired.size(), 2, "second fired");
+    ASSERT_EQ_INT(w.size(), 0, "empty");
+  });
+
+  TEST_CASE(rounds, {
+    wheel w{ms(10), 4};
+    const auto start = wheel::clock::now();
+    int fired = 0;
+    w.schedule(1, ms(100)); // 10 ticks, more than one turn of wheel
+
+    w.advance(start + ms(95), [&fired](int) { ++fired; });
+    ASSERT_EQ_INT(fired, 0, "not fired before deadline");
+
+    w.advance(start + ms(105), [&fired](int) { ++fired; });
+    ASSERT_EQ_INT(fired, 1, "fired after deadline");
+  });
+
+  TEST_CASE(reschedule, {
+    wheel w{ms(10), 4};
+    const auto start = wheel::clock::now();
+    int fired = 0;
+    w.schedule(1, ms(10));
+    w.advance(start + ms(15),
+        [&w, &fired](int id)
+        {
+          ++fired;
+          w.schedule(id, ms(10));
+        });
+    ASSERT_EQ_INT(fired, 1, "fired once");
+    ASSERT_EQ_INT(w.size(), 1, "rescheduled");
+
+    w.advance(start + ms(25), [&fired](int) { ++fired; });
+    ASSERT_EQ_INT(fired, 2, "fired again");
+  });
+
+  auto run() -> void
+  {
+    fire();
+    rounds();
+    reschedule();
+  }
+} // namespace tests::utils::timer_wheel